@@ -0,0 +1,119 @@
+// cylgroup.cc
+//	Routines to allocate disk sectors by cylinder group.  See
+//	cylgroup.h for the policy.
+//
+//	A request that cannot be met in the group asked for tries the
+//	groups after it in turn, then the whole disk, so it only fails
+//	when the disk is full.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "cylgroup.h"
+#include "bitmap.h"
+#include "debug.h"
+
+//----------------------------------------------------------------------
+// CylinderGroups::NumFree
+// 	Return the number of free sectors in "group".
+//----------------------------------------------------------------------
+
+int
+CylinderGroups::NumFree(Bitmap *freeMap, int group)
+{
+    int count = 0;
+
+    for (int i = group * SectorsPerGroup; i < (group + 1) * SectorsPerGroup; i++)
+	if (!freeMap->Test(i))
+	    count++;
+    return count;
+}
+
+//----------------------------------------------------------------------
+// CylinderGroups::EmptiestGroup
+// 	Return the group with the most free sectors, the first one if
+//	there is a tie.
+//----------------------------------------------------------------------
+
+int
+CylinderGroups::EmptiestGroup(Bitmap *freeMap)
+{
+    int best = 0, bestFree = -1;
+
+    for (int group = 0; group < NumGroups; group++) {
+	int numFree = NumFree(freeMap, group);
+
+	if (numFree > bestFree) {
+	    best = group;
+	    bestFree = numFree;
+	}
+    }
+    return best;
+}
+
+//----------------------------------------------------------------------
+// CylinderGroups::PickGroup
+// 	Choose the group for a new file of "numSectors" sectors
+//	(counting its header): "group" if the file fits in it, otherwise
+//	the emptiest group.
+//----------------------------------------------------------------------
+
+int
+CylinderGroups::PickGroup(Bitmap *freeMap, int group, int numSectors)
+{
+    if (NumFree(freeMap, group) >= numSectors)
+	return group;
+    return EmptiestGroup(freeMap);
+}
+
+//----------------------------------------------------------------------
+// CylinderGroups::FindAndSet
+// 	Allocate a single sector: a free one in "group", or in the
+//	first group after it that has one.  Holes are filled first,
+//	to keep the free runs whole.
+//
+//	Return the sector, or -1 if the disk is full.
+//----------------------------------------------------------------------
+
+int
+CylinderGroups::FindAndSet(Bitmap *freeMap, int group)
+{
+    int found;
+
+    return FindAndSetRun(freeMap, group, 1, &found);
+}
+
+//----------------------------------------------------------------------
+// CylinderGroups::FindAndSetRun
+// 	Allocate a run of up to "length" consecutive free sectors, as
+//	Bitmap::FindAndSetRun does.  The run is taken from "group" if it
+//	has one long enough, or else from the first group after it that
+//	has.  If no group does (the run is longer than a group, say), it
+//	is taken from wherever on the disk the best run is.
+//
+//	Return the first sector, and in "found" how many were taken.
+//	Return -1 if the disk is full.
+//----------------------------------------------------------------------
+
+int
+CylinderGroups::FindAndSetRun(Bitmap *freeMap, int group, int length,
+			      int *found)
+{
+    int start;
+
+    ASSERT(group >= 0 && group < NumGroups);
+    for (int i = 0; i < NumGroups; i++) {
+	int g = (group + i) % NumGroups;
+
+	start = freeMap->FindRun(length, found, g * SectorsPerGroup,
+						(g + 1) * SectorsPerGroup);
+	if (start >= 0 && *found == length) {
+	    for (int j = start; j < start + length; j++)
+		freeMap->Mark(j);
+	    return start;
+	}
+    }
+    return freeMap->FindAndSetRun(length, found);
+}
@@ -0,0 +1,49 @@
+// cylgroup.h
+//	Data structures for placing disk blocks by cylinder group, as
+//	the Berkeley Fast File System does.
+//
+//	The disk is cut into NumGroups groups of TracksPerGroup
+//	neighbouring tracks.  A file's header, its data and its indirect
+//	blocks are taken from one group -- the group of the directory it
+//	is in -- so that using the file costs short seeks.  A file that
+//	does not fit in that group, and a new directory, go to the group
+//	with the most free space, so unrelated files spread across the
+//	disk and every group keeps room for the files to come.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef CYLGROUP_H
+#define CYLGROUP_H
+
+#include "copyright.h"
+#include "disk.h"
+
+class Bitmap;
+
+#define TracksPerGroup	4
+#define NumGroups	(NumTracks / TracksPerGroup)
+#define SectorsPerGroup	(TracksPerGroup * SectorsPerTrack)
+
+class CylinderGroups {
+  public:
+    static int GroupOf(int sector) { return sector / SectorsPerGroup; }
+				// the group "sector" is in
+    static int NumFree(Bitmap *freeMap, int group);
+				// free sectors in "group"
+    static int EmptiestGroup(Bitmap *freeMap);
+				// the group with the most free sectors
+    static int PickGroup(Bitmap *freeMap, int group, int numSectors);
+				// "group", if it has room for
+				// "numSectors", else the emptiest one
+    static int FindAndSet(Bitmap *freeMap, int group);
+				// allocate a sector, in "group" if
+				// there is one free there
+    static int FindAndSetRun(Bitmap *freeMap, int group, int length,
+			     int *found);
+				// allocate a run of up to "length"
+				// sectors, in "group" if it fits
+};
+
+#endif // CYLGROUP_H
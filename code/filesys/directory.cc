@@ -7,75 +7,135 @@
 //	of each directory entry means that we have the restriction
 //	of a fixed maximum size for file names.
 //
-//	The constructor initializes an empty directory of a certain size;
-//	we use ReadFrom/WriteBack to fetch the contents of the directory
-//	from disk, and to write back any modifications back to disk.
+//	The table is a hash table with linear probing: a name is
+//	looked for at the entry its hash picks, then the ones after it,
+//	up to the first entry that has never been used.  Removing a
+//	file leaves the entry marked "deleted", so the lookups that
+//	went past it still do.  When 3/4 of the entries have been used,
+//	the next Add rehashes the table into one twice as big (or the
+//	same size, when most of the used entries are deleted ones),
+//	extending the directory file.
 //
-//	Also, this implementation has the restriction that the size
-//	of the directory cannot expand.  In other words, once all the
-//	entries in the directory are used, no more files can be created.
+//	The constructor opens a directory that is on disk; Initialize
+//	writes an empty one.  Each operation reads or writes the
+//	entries it needs right away, so there is no WriteBack.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
 // of liability and disclaimer of warranty provisions.
+#ifndef FILESYS_STUB
 
 #include "copyright.h"
 #include "utility.h"
+#include "debug.h"
 #include "filehdr.h"
 #include "directory.h"
+#include "cylgroup.h"
+
+// Where entry "i" of the table is in the directory file.
+#define EntryOffset(i)	((int)(sizeof(DirectoryHeader) + (i) * sizeof(DirectoryEntry)))
+
+//----------------------------------------------------------------------
+// HashName
+// 	Hash the part of a file name the directory keeps.
+//----------------------------------------------------------------------
+
+static unsigned int
+HashName(char *name)
+{
+    unsigned int hash = 5381;
+
+    for (int i = 0; i < FileNameMaxLen && name[i] != '\0'; i++)
+	hash = hash * 33 + (unsigned char)name[i];
+    return hash;
+}
 
 //----------------------------------------------------------------------
 // Directory::Directory
-// 	Initialize a directory; initially, the directory is completely
-//	empty.  If the disk is being formatted, an empty directory
-//	is all we need, but otherwise, we need to call FetchFrom in order
-//	to initialize it from disk.
+// 	Open a directory that is on disk, reading in its header.  If the
+//	directory is being created, Initialize must be called to write
+//	an empty one first.
 //
-//	"size" is the number of entries in the directory
+//	"sector" is the location of the directory's file header
 //----------------------------------------------------------------------
 
-Directory::Directory(int size)
+Directory::Directory(int sector)
 {
-    table = new DirectoryEntry[size];
-    tableSize = size;
-    for (int i = 0; i < tableSize; i++)
-	table[i].inUse = FALSE;
+    this->sector = sector;
+    file = new OpenFile(sector);
+    (void) file->ReadAt((char *)&header, sizeof(DirectoryHeader), 0);
 }
 
 //----------------------------------------------------------------------
 // Directory::~Directory
-// 	De-allocate directory data structure.
+// 	Close the directory.
 //----------------------------------------------------------------------
 
 Directory::~Directory()
 { 
-    delete [] table;
+    delete file;
 } 
 
 //----------------------------------------------------------------------
-// Directory::FetchFrom
-// 	Read the contents of the directory from disk.
+// Directory::FileSize
+// 	Return the size of a directory file with "size" entries.
+//----------------------------------------------------------------------
+
+int
+Directory::FileSize(int size)
+{
+    return EntryOffset(size);
+}
+
+//----------------------------------------------------------------------
+// Directory::Initialize
+// 	Write an empty directory into our file, which must have room
+//	for "size" entries.
 //
-//	"file" -- file containing the directory contents
+//	"size" is the number of entries in the directory
+//	"parentSector" is where the header of the directory this one is
+//		in is (the root directory is its own parent)
 //----------------------------------------------------------------------
 
 void
-Directory::FetchFrom(OpenFile *file)
+Directory::Initialize(int size, int parentSector)
 {
-    (void) file->ReadAt((char *)table, tableSize * sizeof(DirectoryEntry), 0);
+    char *buf = new char[FileSize(size)];
+
+    ASSERT(file->Length() >= FileSize(size));
+    header.tableSize = size;
+    header.numUsed = header.numFiles = 0;
+    header.parent = parentSector;
+    bzero(buf, FileSize(size));
+    bcopy((char *)&header, buf, sizeof(DirectoryHeader));
+    (void) file->WriteAt(buf, FileSize(size), 0);
+    delete [] buf;
 }
 
 //----------------------------------------------------------------------
-// Directory::WriteBack
-// 	Write any modifications to the directory back to disk
-//
-//	"file" -- file to contain the new directory contents
+// Directory::ReadEntry, WriteEntry, WriteHeader
+// 	Read or write one entry of the table, or the directory header,
+//	in the directory file.
 //----------------------------------------------------------------------
 
 void
-Directory::WriteBack(OpenFile *file)
+Directory::ReadEntry(int index, DirectoryEntry *entry)
+{
+    (void) file->ReadAt((char *)entry, sizeof(DirectoryEntry),
+							EntryOffset(index));
+}
+
+void
+Directory::WriteEntry(int index, DirectoryEntry *entry)
+{
+    (void) file->WriteAt((char *)entry, sizeof(DirectoryEntry),
+							EntryOffset(index));
+}
+
+void
+Directory::WriteHeader()
 {
-    (void) file->WriteAt((char *)table, tableSize * sizeof(DirectoryEntry), 0);
+    (void) file->WriteAt((char *)&header, sizeof(DirectoryHeader), 0);
 }
 
 //----------------------------------------------------------------------
@@ -84,14 +144,22 @@ Directory::WriteBack(OpenFile *file)
 //	directory entries.  Return -1 if the name isn't in the directory.
 //
 //	"name" -- the file name to look up
+//	"entry" -- set to the entry found
 //----------------------------------------------------------------------
 
 int
-Directory::FindIndex(char *name)
+Directory::FindIndex(char *name, DirectoryEntry *entry)
 {
-    for (int i = 0; i < tableSize; i++)
-        if (table[i].inUse && !strncmp(table[i].name, name, FileNameMaxLen))
+    int i = HashName(name) % header.tableSize;
+
+    for (int probes = 0; probes < header.tableSize; probes++) {
+	ReadEntry(i, entry);
+	if (!entry->inUse && !entry->deleted)
+	    break;		// never used: the name would be here
+	if (entry->inUse && !strncmp(entry->name, name, FileNameMaxLen))
 	    return i;
+	i = (i + 1) % header.tableSize;
+    }
     return -1;		// name not in directory
 }
 
@@ -102,43 +170,125 @@ Directory::FindIndex(char *name)
 //	in the directory.
 //
 //	"name" -- the file name to look up
+//	"isDirectory" -- if not NULL, set to whether the file is a
+//		directory
 //----------------------------------------------------------------------
 
 int
-Directory::Find(char *name)
+Directory::Find(char *name, bool *isDirectory)
 {
-    int i = FindIndex(name);
+    DirectoryEntry entry;
 
-    if (i != -1)
-	return table[i].sector;
-    return -1;
+    if (FindIndex(name, &entry) == -1)
+	return -1;
+    if (isDirectory != NULL)
+	*isDirectory = entry.isDirectory;
+    return entry.sector;
 }
 
 //----------------------------------------------------------------------
 // Directory::Add
 // 	Add a file into the directory.  Return TRUE if successful;
 //	return FALSE if the file name is already in the directory, or if
-//	the directory is completely full, and has no more space for
-//	additional file names.
+//	the directory is full and the disk has no room to make it bigger.
 //
 //	"name" -- the name of the file being added
 //	"newSector" -- the disk sector containing the added file's header
+//	"isDirectory" -- is the file a directory?
+//	"freeMap" -- the bit map of free disk sectors, for growing
 //----------------------------------------------------------------------
 
 bool
-Directory::Add(char *name, int newSector)
+Directory::Add(char *name, int newSector, bool isDirectory,
+					PersistentBitmap *freeMap)
 { 
-    if (FindIndex(name) != -1)
+    DirectoryEntry entry;
+    int i;
+
+    if (FindIndex(name, &entry) != -1)
 	return FALSE;
+    if (((header.numUsed + 1) * 4 > header.tableSize * 3) && !Grow(freeMap))
+	return FALSE;	// no space
+
+    // take the first entry not in use where the name hashes to
+    for (i = HashName(name) % header.tableSize; ;
+				i = (i + 1) % header.tableSize) {
+	ReadEntry(i, &entry);
+	if (!entry.inUse)
+	    break;
+    }
+    if (!entry.deleted)
+	header.numUsed++;
+    entry.inUse = TRUE;
+    entry.deleted = FALSE;
+    entry.isDirectory = isDirectory;
+    entry.sector = newSector;
+    strncpy(entry.name, name, FileNameMaxLen); 
+    entry.name[FileNameMaxLen] = '\0';
+    WriteEntry(i, &entry);
+    header.numFiles++;
+    WriteHeader();
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Directory::Grow
+// 	Rehash the table.  If more than half of the entries hold files,
+//	the table doubles, and the directory file is extended to hold
+//	it; otherwise it keeps its size, and only the deleted entries go.
+//	Return FALSE if there is no room on disk.
+//
+//	"freeMap" -- the bit map of free disk sectors
+//----------------------------------------------------------------------
+
+bool
+Directory::Grow(PersistentBitmap *freeMap)
+{
+    int oldSize = header.tableSize, newSize = oldSize;
+    DirectoryEntry *oldTable, *newTable;
+
+    if ((header.numFiles + 1) * 2 > oldSize)
+	newSize = oldSize * 2;
+    oldTable = new DirectoryEntry[oldSize];
+    (void) file->ReadAt((char *)oldTable, oldSize * sizeof(DirectoryEntry),
+							EntryOffset(0));
+    if (newSize > oldSize) {
+	FileHeader *hdr = new FileHeader;
+	bool success;
+
+	hdr->FetchFrom(sector);
+	success = hdr->Extend(freeMap, FileSize(newSize),
+				CylinderGroups::GroupOf(sector));
+	if (success)
+	    hdr->WriteBack(sector);
+	delete hdr;
+	if (!success) {
+	    delete [] oldTable;
+	    return FALSE;
+	}
+	delete file;			// reopen, to see the new length
+	file = new OpenFile(sector);
+    }
+
+    newTable = new DirectoryEntry[newSize];
+    bzero((char *)newTable, newSize * sizeof(DirectoryEntry));
+    for (int i = 0; i < oldSize; i++) {
+	if (oldTable[i].inUse) {
+	    int j = HashName(oldTable[i].name) % newSize;
 
-    for (int i = 0; i < tableSize; i++)
-        if (!table[i].inUse) {
-            table[i].inUse = TRUE;
-            strncpy(table[i].name, name, FileNameMaxLen); 
-            table[i].sector = newSector;
-        return TRUE;
+	    while (newTable[j].inUse)
+		j = (j + 1) % newSize;
+	    newTable[j] = oldTable[i];
 	}
-    return FALSE;	// no space.  Fix when we have extensible files.
+    }
+    (void) file->WriteAt((char *)newTable, newSize * sizeof(DirectoryEntry),
+							EntryOffset(0));
+    header.tableSize = newSize;
+    header.numUsed = header.numFiles;
+    WriteHeader();
+    delete [] oldTable;
+    delete [] newTable;
+    return TRUE;
 }
 
 //----------------------------------------------------------------------
@@ -152,45 +302,79 @@ Directory::Add(char *name, int newSector)
 bool
 Directory::Remove(char *name)
 { 
-    int i = FindIndex(name);
+    DirectoryEntry entry;
+    int i = FindIndex(name, &entry);
 
     if (i == -1)
 	return FALSE; 		// name not in directory
-    table[i].inUse = FALSE;
+    entry.inUse = FALSE;
+    entry.deleted = TRUE;
+    WriteEntry(i, &entry);
+    header.numFiles--;
+    WriteHeader();
     return TRUE;	
 }
 
 //----------------------------------------------------------------------
 // Directory::List
-// 	List all the file names in the directory. 
+// 	List all the file names in the directory, and in the directories
+//	below it; directory names end in '/'.
+//
+//	"depth" -- how deep we are in the tree, for indenting
 //----------------------------------------------------------------------
 
 void
-Directory::List()
+Directory::List(int depth)
 {
-   for (int i = 0; i < tableSize; i++)
-	if (table[i].inUse)
-	    printf("%s\n", table[i].name);
+    DirectoryEntry entry;
+
+    for (int i = 0; i < header.tableSize; i++) {
+	ReadEntry(i, &entry);
+	if (entry.inUse) {
+	    printf("%*s%s%s\n", 2 * depth, "", entry.name,
+					entry.isDirectory ? "/" : "");
+	    if (entry.isDirectory) {
+		Directory *directory = new Directory(entry.sector);
+
+		directory->List(depth + 1);
+		delete directory;
+	    }
+	}
+    }
 }
 
 //----------------------------------------------------------------------
 // Directory::Print
 // 	List all the file names in the directory, their FileHeader locations,
-//	and the contents of each file.  For debugging.
+//	and the contents of each file, going down into the directories
+//	below this one.  For debugging.
 //----------------------------------------------------------------------
 
 void
 Directory::Print()
 { 
     FileHeader *hdr = new FileHeader;
+    DirectoryEntry entry;
 
-    printf("Directory contents:\n");
-    for (int i = 0; i < tableSize; i++)
-	if (table[i].inUse) {
-	    printf("Name: %s, Sector: %d\n", table[i].name, table[i].sector);
-	    hdr->FetchFrom(table[i].sector);
+    printf("Directory contents (%d files, %d entries):\n", header.numFiles,
+							header.tableSize);
+    for (int i = 0; i < header.tableSize; i++) {
+	ReadEntry(i, &entry);
+	if (entry.inUse) {
+	    printf("Name: %s%s, Sector: %d\n", entry.name,
+			entry.isDirectory ? "/" : "", entry.sector);
+	    hdr->FetchFrom(entry.sector);
 	    hdr->Print();
+	    if (entry.isDirectory) {
+		Directory *directory = new Directory(entry.sector);
+
+		directory->Print();
+		delete directory;
+	    }
 	}
+    }
     printf("\n");
     delete hdr;
 }
+
+#endif // FILESYS_STUB
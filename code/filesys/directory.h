@@ -4,7 +4,13 @@
 //      A directory is a table of pairs: <file name, sector #>,
 //	giving the name of each file in the directory, and 
 //	where to find its file header (the data structure describing
-//	where to find the file's data blocks) on disk.
+//	where to find the file's data blocks) on disk.  An entry can
+//	name another directory, so directories form a tree.
+//
+//	The table is an open-addressed hash table, kept on disk: a
+//	lookup reads the few entries its name hashes to, not the whole
+//	directory, so it stays fast however many files there are.  The
+//	table doubles in size when it gets 3/4 full.
 //
 //      We assume mutual exclusion is provided by the caller.
 //
@@ -19,6 +25,8 @@
 
 #include "openfile.h"
 
+class PersistentBitmap;
+
 #define FileNameMaxLen 		9	// for simplicity, we assume 
 					// file names are <= 9 characters long
 
@@ -32,52 +40,89 @@
 class DirectoryEntry {
   public:
     bool inUse;				// Is this directory entry in use?
+    bool deleted;			// Was it in use?  Lookups must then
+					//   go on past it
+    bool isDirectory;			// Is the file a directory?
     int sector;				// Location on disk to find the 
 					//   FileHeader for this file 
     char name[FileNameMaxLen + 1];	// Text name for file, with +1 for 
 					// the trailing '\0'
 };
 
+// The first bytes of a directory file, before the table of entries.
+
+class DirectoryHeader {
+  public:
+    int tableSize;			// Number of directory entries
+    int numUsed;			// Entries in use or deleted
+    int numFiles;			// Entries in use
+    int parent;				// Sector of the header of the
+					//   directory this one is in
+};
+
 // The following class defines a UNIX-like "directory".  Each entry in
 // the directory describes a file, and where to find it on disk.
 //
-// The directory data structure can be stored in memory, or on disk.
-// When it is on disk, it is stored as a regular Nachos file.
+// The directory data structure is stored on disk, as a regular Nachos
+// file; only its DirectoryHeader is kept in memory.  Each operation
+// reads and writes the entries it needs straight from the file, through
+// the sector cache.
 //
-// The constructor initializes a directory structure in memory; the
-// FetchFrom/WriteBack operations shuffle the directory information
-// from/to disk. 
+// The constructor opens an existing directory; Initialize makes the
+// (freshly allocated) file an empty directory.
 
 class Directory {
   public:
-    Directory(int size); 		// Initialize an empty directory
+    Directory(int sector);		// Open the directory whose file
+					// header is at "sector"
+    ~Directory();			// Close the directory
+
+    static int FileSize(int size);	// Bytes in a directory file with
+					// room for "size" files
+    void Initialize(int size, int parentSector);
+					// Make this an empty directory,
 					// with space for "size" files
-    ~Directory();			// De-allocate the directory
-
-    void FetchFrom(OpenFile *file);  	// Init directory contents from disk
-    void WriteBack(OpenFile *file);	// Write modifications to 
-					// directory contents back to disk
 
-    int Find(char *name);		// Find the sector number of the 
+    int Find(char *name, bool *isDirectory = NULL);
+					// Find the sector number of the
 					// FileHeader for file: "name"
 
-    bool Add(char *name, int newSector);  // Add a file name into the directory
+    bool Add(char *name, int newSector, bool isDirectory,
+	     PersistentBitmap *freeMap);
+					// Add a file name into the directory,
+					// making the directory bigger from
+					// "freeMap" if need be
 
     bool Remove(char *name);		// Remove a file from the directory
 
-    void List();			// Print the names of all the files
-					//  in the directory
+    bool IsEmpty() { return header.numFiles == 0; }
+    int Parent() { return header.parent; }
+
+    void List(int depth);		// Print the names of all the files
+					//  in the directory, and in the
+					//  ones below it, indented by
+					//  "depth"
     void Print();			// Verbose print of the contents
 					//  of the directory -- all the file
 					//  names and their contents.
 
   private:
-    int tableSize;			// Number of directory entries
-    DirectoryEntry *table;		// Table of pairs: 
-					// <file name, file header location> 
-
-    int FindIndex(char *name);		// Find the index into the directory 
-					//  table corresponding to "name"
+    int sector;				// Where our file header is
+    OpenFile *file;			// The directory file
+    DirectoryHeader header;		// Its first bytes
+
+    int FindIndex(char *name, DirectoryEntry *entry);
+					// Find the index into the directory
+					//  table corresponding to "name",
+					//  and read the entry
+    void ReadEntry(int index, DirectoryEntry *entry);
+    void WriteEntry(int index, DirectoryEntry *entry);
+					// Transfer entry "index" of the table
+    void WriteHeader();			// Write "header" back to the file
+    bool Grow(PersistentBitmap *freeMap);
+					// Rehash the table into one twice
+					//  as big (or just clear out the
+					//  deleted entries)
 };
 
 #endif // DIRECTORY_H
@@ -4,11 +4,12 @@
 //
 //	The file header is used to locate where on disk the 
 //	file's data is stored.  We implement this as a fixed size
-//	table of pointers -- each entry in the table points to the 
-//	disk sector containing that portion of the file data
-//	(in other words, there are no indirect or doubly indirect 
-//	blocks). The table size is chosen so that the file header
-//	will be just big enough to fit in one disk sector, 
+//	table of extents -- each entry in the table gives the run of
+//	consecutive disk sectors containing that portion of the file
+//	data -- followed by a single indirect and a doubly indirect
+//	block for the extents that do not fit.  The table size is
+//	chosen so that the file header will be just big enough to fit
+//	in one disk sector, 
 //
 //      Unlike in a real system, we do not keep track of file permissions, 
 //	ownership, last modification date, etc., in the file header. 
@@ -21,45 +22,141 @@
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
 // of liability and disclaimer of warranty provisions.
+#ifndef FILESYS_STUB
 
 #include "copyright.h"
 
 #include "filehdr.h"
 #include "debug.h"
-#include "synchdisk.h"
+#include "sectorcache.h"
+#include "cylgroup.h"
 #include "main.h"
 
+//----------------------------------------------------------------------
+// NumIndirectBlocks
+// 	Return how many indirect blocks (not counting the doubly
+//	indirect one) a file of "numExtents" extents needs.
+//----------------------------------------------------------------------
+
+static int
+NumIndirectBlocks(int numExtents)
+{
+    int rest = numExtents - NumDirect;
+
+    if (rest <= 0)
+	return 0;
+    return divRoundUp(rest, ExtentsPerBlock);
+}
+
 //----------------------------------------------------------------------
 // FileHeader::Allocate
 // 	Initialize a fresh file header for a newly created file.
-//	Allocate data blocks for the file out of the map of free disk blocks.
+//	Allocate data blocks for the file out of the map of free disk
+//	blocks, as Extend does.
 //	Return FALSE if there are not enough free blocks to accomodate
 //	the new file.
 //
 //	"freeMap" is the bit map of free disk sectors
-//	"fileSize" is the bit map of free disk sectors
+//	"fileSize" is the size of the file in bytes
+//	"group" is the cylinder group of the file
 //----------------------------------------------------------------------
 
 bool
-FileHeader::Allocate(PersistentBitmap *freeMap, int fileSize)
+FileHeader::Allocate(PersistentBitmap *freeMap, int fileSize, int group)
 { 
-    numBytes = fileSize;
-    numSectors  = divRoundUp(fileSize, SectorSize);
-    if (freeMap->NumClear() < numSectors)
+    numBytes = 0;
+    numExtents = 0;
+    indirectSector = doubleIndirectSector = -1;
+    for (int i = 0; i < NumDirect; i++) {
+	extents[i].start = -1;
+	extents[i].length = 0;
+    }
+    cachedIndex = -1;
+    lastExtent = lastFirst = 0;
+    return Extend(freeMap, fileSize, group);
+}
+
+//----------------------------------------------------------------------
+// FileHeader::Extend
+// 	Make the file "newSize" bytes long.  The last extent grows in
+//	place as far as the sectors after it are free; the rest is
+//	allocated in as few runs of consecutive sectors as we can, with
+//	the indirect blocks needed to hold the new extents -- all of them
+//	from cylinder group "group" as far as it has room.
+//
+//	Return FALSE, leaving the file as it was, if there are not
+//	enough free blocks (or the free space is in too many pieces).
+//	The caller must write the header back.
+//
+//	"freeMap" is the bit map of free disk sectors
+//	"newSize" is the new size of the file in bytes, no smaller
+//	"group" is the cylinder group of the file
+//----------------------------------------------------------------------
+
+bool
+FileHeader::Extend(PersistentBitmap *freeMap, int newSize, int group)
+{
+    int oldSectors = divRoundUp(numBytes, SectorSize);
+    int numSectors = divRoundUp(newSize, SectorSize);
+    int grown = 0, numRuns = 0, numBlocks, length, i, j;
+    Extent last, *runs;
+
+    ASSERT(newSize >= numBytes);
+    if (freeMap->NumClear() < numSectors - oldSectors)
 	return FALSE;		// not enough space
 
-    for (int i = 0; i < numSectors; i++) {
-	dataSectors[i] = freeMap->FindAndSet();
+    last.start = last.length = 0;
+    if (numExtents > 0) {
+	last = GetExtent(numExtents - 1);
+	for (i = last.start + last.length; (oldSectors + grown < numSectors)
+		&& (i < NumSectors) && !freeMap->Test(i); i++, grown++)
+	    freeMap->Mark(i);
+    }
+
+    runs = new Extent[MaxExtents];
+    for (i = oldSectors + grown;
+	 (i < numSectors) && (numExtents + numRuns < MaxExtents); i += length) {
+	runs[numRuns].start = CylinderGroups::FindAndSetRun(freeMap, group,
+						numSectors - i, &length);
 	// since we checked that there was enough free space,
 	// we expect this to succeed
-	ASSERT(dataSectors[i] >= 0);
+	ASSERT(runs[numRuns].start >= 0);
+	runs[numRuns++].length = length;
     }
+
+    // the new indirect blocks count against the free space too
+    numBlocks = NumIndirectBlocks(numExtents + numRuns)
+					- NumIndirectBlocks(numExtents);
+    if ((NumIndirectBlocks(numExtents + numRuns) > 1)
+					&& (doubleIndirectSector < 0))
+	numBlocks++;
+    if ((i < numSectors) || (freeMap->NumClear() < numBlocks)) {
+	for (j = 0; j < grown; j++)		// give the sectors back
+	    freeMap->Clear(last.start + last.length + j);
+	for (j = 0; j < numRuns; j++)
+	    for (int k = 0; k < runs[j].length; k++)
+		freeMap->Clear(runs[j].start + k);
+	delete [] runs;
+	return FALSE;
+    }
+
+    if (grown > 0) {
+	last.length += grown;
+	SetExtent(numExtents - 1, last, freeMap, group);
+    }
+    for (j = 0; j < numRuns; j++) {
+	SetExtent(numExtents, runs[j], freeMap, group);
+	numExtents++;
+    }
+    numBytes = newSize;
+    delete [] runs;
     return TRUE;
 }
 
 //----------------------------------------------------------------------
 // FileHeader::Deallocate
-// 	De-allocate all the space allocated for data blocks for this file.
+// 	De-allocate all the space allocated for data blocks for this file,
+//	and for the indirect blocks.
 //
 //	"freeMap" is the bit map of free disk sectors
 //----------------------------------------------------------------------
@@ -67,9 +164,25 @@ FileHeader::Allocate(PersistentBitmap *freeMap, int fileSize)
 void 
 FileHeader::Deallocate(PersistentBitmap *freeMap)
 {
-    for (int i = 0; i < numSectors; i++) {
-	ASSERT(freeMap->Test((int) dataSectors[i]));  // ought to be marked!
-	freeMap->Clear((int) dataSectors[i]);
+    int sector;
+
+    for (int i = 0; i < numExtents; i++) {
+	Extent extent = GetExtent(i);
+
+	for (sector = extent.start; sector < extent.start + extent.length;
+								sector++) {
+	    ASSERT(freeMap->Test(sector));  // ought to be marked!
+	    freeMap->Clear(sector);
+	}
+    }
+    for (int i = 0; i < NumIndirectBlocks(numExtents); i++) {
+	sector = IndirectSector(i);
+	ASSERT(freeMap->Test(sector));
+	freeMap->Clear(sector);
+    }
+    if (doubleIndirectSector >= 0) {
+	ASSERT(freeMap->Test(doubleIndirectSector));
+	freeMap->Clear(doubleIndirectSector);
     }
 }
 
@@ -83,7 +196,9 @@ FileHeader::Deallocate(PersistentBitmap *freeMap)
 void
 FileHeader::FetchFrom(int sector)
 {
-    kernel->synchDisk->ReadSector(sector, (char *)this);
+    kernel->sectorCache->ReadSector(sector, (char *)this);
+    cachedIndex = -1;
+    lastExtent = lastFirst = 0;
 }
 
 //----------------------------------------------------------------------
@@ -96,7 +211,7 @@ FileHeader::FetchFrom(int sector)
 void
 FileHeader::WriteBack(int sector)
 {
-    kernel->synchDisk->WriteSector(sector, (char *)this); 
+    kernel->sectorCache->WriteSector(sector, (char *)this); 
 }
 
 //----------------------------------------------------------------------
@@ -112,7 +227,129 @@ FileHeader::WriteBack(int sector)
 int
 FileHeader::ByteToSector(int offset)
 {
-    return(dataSectors[offset / SectorSize]);
+    int block = offset / SectorSize;
+    Extent extent;
+
+    if (block < lastFirst) {		// behind the last one: start over
+	lastExtent = 0;
+	lastFirst = 0;
+    }
+    for (;;) {
+	ASSERT(lastExtent < numExtents);
+	extent = GetExtent(lastExtent);
+	if (block < lastFirst + extent.length)
+	    return(extent.start + block - lastFirst);
+	lastFirst += extent.length;
+	lastExtent++;
+    }
+}
+
+//----------------------------------------------------------------------
+// FileHeader::IndirectSector
+// 	Return the sector of indirect block "index": 0 is the single
+//	indirect block, k + 1 the k'th one the doubly indirect block
+//	points to.
+//----------------------------------------------------------------------
+
+int
+FileHeader::IndirectSector(int index)
+{
+    int block[NumIndirect];
+
+    if (index == 0)
+	return indirectSector;
+    kernel->sectorCache->ReadSector(doubleIndirectSector, (char *)block);
+    return block[index - 1];
+}
+
+//----------------------------------------------------------------------
+// FileHeader::GetExtent
+// 	Return extent "which" of the file.  If it is in an indirect block,
+//	read the block in, unless it is the one read last.
+//----------------------------------------------------------------------
+
+Extent
+FileHeader::GetExtent(int which)
+{
+    int index;
+
+    if (which < NumDirect)
+	return extents[which];
+    which -= NumDirect;
+    index = which / ExtentsPerBlock;
+    if (index != cachedIndex) {
+	kernel->sectorCache->ReadSector(IndirectSector(index),
+						(char *)cachedBlock);
+	cachedIndex = index;
+    }
+    return cachedBlock[which % ExtentsPerBlock];
+}
+
+//----------------------------------------------------------------------
+// FileHeader::SetExtent
+// 	Store extent "which" of the file, in the header or in an
+//	indirect block.  An extent appended at the start of a new
+//	indirect block gets the block allocated.
+//
+//	"which" is the extent, at most numExtents
+//	"extent" is what to store
+//	"freeMap", "group" -- where to take a new indirect block from
+//----------------------------------------------------------------------
+
+void
+FileHeader::SetExtent(int which, Extent extent, PersistentBitmap *freeMap,
+								int group)
+{
+    int index;
+
+    if (which < NumDirect) {
+	extents[which] = extent;
+	return;
+    }
+    index = (which - NumDirect) / ExtentsPerBlock;
+    if (index == NumIndirectBlocks(numExtents))
+	NewIndirect(index, freeMap, group);
+    else
+	(void) GetExtent(which);		// read the block in
+    cachedBlock[(which - NumDirect) % ExtentsPerBlock] = extent;
+    kernel->sectorCache->WriteSector(IndirectSector(index),
+						(char *)cachedBlock);
+}
+
+//----------------------------------------------------------------------
+// FileHeader::NewIndirect
+// 	Allocate indirect block "index", and the doubly indirect block
+//	too if this is the first block it points to.  The new block is
+//	left empty in cachedBlock, for the caller to fill in and write.
+//----------------------------------------------------------------------
+
+void
+FileHeader::NewIndirect(int index, PersistentBitmap *freeMap, int group)
+{
+    int sector = CylinderGroups::FindAndSet(freeMap, group);
+
+    ASSERT(sector >= 0);		// Extend checked there was room
+    if (index == 0)
+	indirectSector = sector;
+    else {
+	int block[NumIndirect];
+
+	if (doubleIndirectSector < 0) {
+	    doubleIndirectSector = CylinderGroups::FindAndSet(freeMap, group);
+	    ASSERT(doubleIndirectSector >= 0);
+	    for (int i = 0; i < NumIndirect; i++)
+		block[i] = -1;
+	} else
+	    kernel->sectorCache->ReadSector(doubleIndirectSector,
+							(char *)block);
+	block[index - 1] = sector;
+	kernel->sectorCache->WriteSector(doubleIndirectSector, (char *)block);
+    }
+    for (int i = 0; i < ExtentsPerBlock; i++) {
+	cachedBlock[i].start = -1;
+	cachedBlock[i].length = 0;
+    }
+    cachedIndex = index;
 }
 
 //----------------------------------------------------------------------
@@ -138,12 +375,20 @@ FileHeader::Print()
     int i, j, k;
     char *data = new char[SectorSize];
 
-    printf("FileHeader contents.  File size: %d.  File blocks:\n", numBytes);
-    for (i = 0; i < numSectors; i++)
-	printf("%d ", dataSectors[i]);
+    printf("FileHeader contents.  File size: %d.  File extents:\n", numBytes);
+    for (i = 0; i < numExtents; i++) {
+	Extent extent = GetExtent(i);
+
+	printf("%d-%d ", extent.start, extent.start + extent.length - 1);
+    }
+    printf("\nIndirect blocks:\n");
+    for (i = 0; i < NumIndirectBlocks(numExtents); i++)
+	printf("%d ", IndirectSector(i));
+    if (doubleIndirectSector >= 0)
+	printf("(doubly indirect %d)", doubleIndirectSector);
     printf("\nFile contents:\n");
-    for (i = k = 0; i < numSectors; i++) {
-	kernel->synchDisk->ReadSector(dataSectors[i], data);
+    for (i = k = 0; k < numBytes; i++) {
+	kernel->sectorCache->ReadSector(ByteToSector(i * SectorSize), data);
         for (j = 0; (j < SectorSize) && (k < numBytes); j++, k++) {
 	    if ('\040' <= data[j] && data[j] <= '\176')   // isprint(data[j])
 		printf("%c", data[j]);
@@ -154,3 +399,5 @@ FileHeader::Print()
     }
     delete [] data;
 }
+
+#endif // FILESYS_STUB
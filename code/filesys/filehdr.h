@@ -17,29 +17,56 @@
 #include "disk.h"
 #include "pbitmap.h"
 
-#define NumDirect 	((SectorSize - 2 * sizeof(int)) / sizeof(int))
-#define MaxFileSize 	(NumDirect * SectorSize)
+// An extent: "length" consecutive disk sectors, starting at "start",
+// holding that many consecutive sectors of the file.
+
+class Extent {
+  public:
+    int start;				// First disk sector of the run
+    int length;				// Number of sectors in it
+};
+
+#define NumDirect 	((int)((SectorSize - 4 * sizeof(int)) / sizeof(Extent)))
+#define ExtentsPerBlock	((int)(SectorSize / sizeof(Extent)))
+#define NumIndirect	((int)(SectorSize / sizeof(int)))
+#define MaxExtents	(NumDirect + ExtentsPerBlock + NumIndirect * ExtentsPerBlock)
 
 // The following class defines the Nachos "file header" (in UNIX terms,  
 // the "i-node"), describing where on disk to find all of the data in the file.
-// The file header is organized as a simple table of pointers to
-// data blocks. 
+// The file header is organized as a table of extents: the data of the
+// file is stored in a few runs of consecutive sectors, allocated with
+// Bitmap::FindAndSetRun, so reading a file sequentially needs few
+// seeks, and the header stays small however big the file is.
+//
+// The first NumDirect extents are kept in the header itself.  The next
+// ExtentsPerBlock are in a single indirect block (a sector full of
+// extents), and the rest in the indirect blocks whose sector numbers
+// are in a doubly indirect block.  Only a file broken up into many
+// pieces, on a fragmented disk, needs them.
 //
 // The file header data structure can be stored in memory or on disk.
 // When it is on disk, it is stored in a single sector -- this means
-// that we assume the size of this data structure to be the same
-// as one disk sector.  Without indirect addressing, this
-// limits the maximum file length to just under 4K bytes.
+// that we assume the size of the fields before "cachedIndex" to be
+// the same as one disk sector.  The fields after it only live in
+// memory: the last indirect block read, and the last extent
+// ByteToSector used, so a sequential pass through the file finds
+// each sector without searching.
 //
-// There is no constructor; rather the file header can be initialized
-// by allocating blocks for the file (if it is a new file), or by
-// reading it from disk.
+// The constructor does not set up the header; rather the file header
+// is initialized by allocating blocks for the file (if it is a new
+// file), or by reading it from disk.
 
 class FileHeader {
   public:
-    bool Allocate(PersistentBitmap *bitMap, int fileSize);// Initialize a file header, 
+    FileHeader() { cachedIndex = -1; lastExtent = lastFirst = 0; }
+
+    bool Allocate(PersistentBitmap *bitMap, int fileSize, int group);
+						// Initialize a file header, 
 						//  including allocating space 
-						//  on disk for the file data
+						//  on disk for the file data,
+						//  in cylinder group "group"
+    bool Extend(PersistentBitmap *bitMap, int newSize, int group);
+						// Make the file bigger
     void Deallocate(PersistentBitmap *bitMap);  // De-allocate this file's 
 						//  data blocks
 
@@ -58,9 +85,27 @@ class FileHeader {
 
   private:
     int numBytes;			// Number of bytes in the file
-    int numSectors;			// Number of data sectors in the file
-    int dataSectors[NumDirect];		// Disk sector numbers for each data 
-					// block in the file
+    int numExtents;			// Number of extents in the file
+    int indirectSector;			// Single indirect block, or -1
+    int doubleIndirectSector;		// Doubly indirect block, or -1
+    Extent extents[NumDirect];		// The first extents of the file
+
+    int cachedIndex;			// Which indirect block is cached:
+					// 0 for the single one, k + 1 for
+					// the k'th of the doubly indirect
+					// one, -1 for none
+    Extent cachedBlock[ExtentsPerBlock];	// Its contents
+    int lastExtent;			// The extent ByteToSector found last
+    int lastFirst;			// The first file sector in it
+
+    int IndirectSector(int index);	// Where indirect block "index" is
+    Extent GetExtent(int which);	// Extent "which" of the file,
+					// from the header or an indirect
+					// block, cf. cachedIndex
+    void SetExtent(int which, Extent extent, PersistentBitmap *freeMap,
+		   int group);		// Store extent "which"
+    void NewIndirect(int index, PersistentBitmap *freeMap, int group);
+					// Allocate indirect block "index"
 };
 
 #endif // FILEHDR_H
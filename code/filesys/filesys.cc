@@ -11,20 +11,24 @@
 //
 // 	The file system consists of several data structures:
 //	   A bitmap of free disk sectors (cf. bitmap.h)
-//	   A directory of file names and file headers
+//	   A tree of directories of file names and file headers, starting
+//	     at the root directory
 //
-//      Both the bitmap and the directory are represented as normal
-//	files.  Their file headers are located in specific sectors
-//	(sector 0 and sector 1), so that the file system can find them 
-//	on bootup.
+//      Both the bitmap and the directories are represented as normal
+//	files.  The file headers of the bitmap and the root directory are
+//	located in specific sectors (sector 0 and sector 1), so that the
+//	file system can find them on bootup.
 //
-//	The file system assumes that the bitmap and directory files are
-//	kept "open" continuously while Nachos is running.
+//	A file is named by a path of directory names and a file name,
+//	separated by '/', like "a/b/c"; the path is always taken from
+//	the root directory, and may use "." and "..".
+//
+//	The file system assumes that the bitmap file is kept "open"
+//	continuously while Nachos is running.
 //
 //	For those operations (such as Create, Remove) that modify the
 //	directory and/or bitmap, if the operation succeeds, the changes
-//	are written immediately back to disk (the two files are kept
-//	open during all this time).  If the operation fails, and we have
+//	are written immediately back to disk.  If the operation fails, and we have
 //	modified part of the directory and/or bitmap, we simply discard
 //	the changed version, without writing it back to disk.
 //
@@ -32,9 +36,7 @@
 //
 //	   there is no synchronization for concurrent accesses
 //	   files have a fixed size, set when the file is created
-//	   files cannot be bigger than about 3KB in size
-//	   there is no hierarchical directory structure, and only a limited
-//	     number of files can be added to the system
+//	   file names cannot be longer than 9 characters
 //	   there is no attempt to make the system robust to failures
 //	    (if Nachos exits in the middle of an operation that modifies
 //	    the file system, it may corrupt the disk)
@@ -51,29 +53,28 @@
 #include "directory.h"
 #include "filehdr.h"
 #include "filesys.h"
+#include "cylgroup.h"
 
 // Sectors containing the file headers for the bitmap of free sectors,
-// and the directory of files.  These file headers are placed in well-known 
+// and the root directory.  These file headers are placed in well-known 
 // sectors, so that they can be located on boot-up.
 #define FreeMapSector 		0
 #define DirectorySector 	1
 
-// Initial file sizes for the bitmap and directory; until the file system
-// supports extensible files, the directory size sets the maximum number 
-// of files that can be loaded onto the disk.
+// Initial file sizes for the bitmap and directories; a directory
+// grows past its initial number of entries as files are added to it.
 #define FreeMapFileSize 	(NumSectors / BitsInByte)
 #define NumDirEntries 		10
-#define DirectoryFileSize 	(sizeof(DirectoryEntry) * NumDirEntries)
 
 //----------------------------------------------------------------------
 // FileSystem::FileSystem
 // 	Initialize the file system.  If format = TRUE, the disk has
 //	nothing on it, and we need to initialize the disk to contain
-//	an empty directory, and a bitmap of free sectors (with almost but
-//	not all of the sectors marked as free).  
+//	an empty root directory, and a bitmap of free sectors (with almost
+//	but not all of the sectors marked as free).  
 //
-//	If format = FALSE, we just have to open the files
-//	representing the bitmap and the directory.
+//	If format = FALSE, we just have to open the file
+//	representing the bitmap.
 //
 //	"format" -- should we initialize the disk?
 //----------------------------------------------------------------------
@@ -83,9 +84,9 @@ FileSystem::FileSystem(bool format)
     DEBUG(dbgFile, "Initializing the file system.");
     if (format) {
         PersistentBitmap *freeMap = new PersistentBitmap(NumSectors);
-        Directory *directory = new Directory(NumDirEntries);
 	FileHeader *mapHdr = new FileHeader;
 	FileHeader *dirHdr = new FileHeader;
+	Directory *directory;
 
         DEBUG(dbgFile, "Formatting the file system.");
 
@@ -97,8 +98,10 @@ FileSystem::FileSystem(bool format)
     // Second, allocate space for the data blocks containing the contents
     // of the directory and bitmap files.  There better be enough space!
 
-	ASSERT(mapHdr->Allocate(freeMap, FreeMapFileSize));
-	ASSERT(dirHdr->Allocate(freeMap, DirectoryFileSize));
+	ASSERT(mapHdr->Allocate(freeMap, FreeMapFileSize,
+				CylinderGroups::GroupOf(FreeMapSector)));
+	ASSERT(dirHdr->Allocate(freeMap, Directory::FileSize(NumDirEntries),
+				CylinderGroups::GroupOf(DirectorySector)));
 
     // Flush the bitmap and directory FileHeaders back to disk
     // We need to do this before we can "Open" the file, since open
@@ -110,21 +113,22 @@ FileSystem::FileSystem(bool format)
 	dirHdr->WriteBack(DirectorySector);
 
     // OK to open the bitmap and directory files now
-    // The file system operations assume these two files are left open
+    // The file system operations assume the bitmap file is left open
     // while Nachos is running.
 
         freeMapFile = new OpenFile(FreeMapSector);
-        directoryFile = new OpenFile(DirectorySector);
+	directory = new Directory(DirectorySector);
      
     // Once we have the files "open", we can write the initial version
     // of each file back to disk.  The directory at this point is completely
-    // empty; but the bitmap has been changed to reflect the fact that
-    // sectors on the disk have been allocated for the file headers and
-    // to hold the file data for the directory and bitmap.
+    // empty (the root is its own parent); but the bitmap has been changed
+    // to reflect the fact that sectors on the disk have been allocated
+    // for the file headers and to hold the file data for the directory
+    // and bitmap.
 
         DEBUG(dbgFile, "Writing bitmap and directory back to disk.");
 	freeMap->WriteBack(freeMapFile);	 // flush changes to disk
-	directory->WriteBack(directoryFile);
+	directory->Initialize(NumDirEntries, DirectorySector);
 
 	if (debug->IsEnabled('f')) {
 	    freeMap->Print();
@@ -135,75 +139,179 @@ FileSystem::FileSystem(bool format)
 	delete mapHdr; 
 	delete dirHdr;
     } else {
-    // if we are not formatting the disk, just open the files representing
-    // the bitmap and directory; these are left open while Nachos is running
+    // if we are not formatting the disk, just open the file representing
+    // the bitmap; it is left open while Nachos is running
         freeMapFile = new OpenFile(FreeMapSector);
-        directoryFile = new OpenFile(DirectorySector);
     }
 }
 
+//----------------------------------------------------------------------
+// FileSystem::FindParent
+// 	Walk down the directory tree along the path "name", up to (but
+//	not including) its last component.  Return the sector of the
+//	header of the directory the last component is to be found in,
+//	and copy the last component into "last" (truncated to
+//	FileNameMaxLen characters; empty if "name" is the root itself).
+//
+//	Return -1 if a directory along the way does not exist, or if
+//	the last component is "." or "..", which cannot be created or
+//	removed.
+//
+//	"name" -- the path of a file, like "a/b/c"
+//	"last" -- room for FileNameMaxLen + 1 characters
+//----------------------------------------------------------------------
+
+int
+FileSystem::FindParent(char *name, char *last)
+{
+    int dirSector = DirectorySector;
+    Directory *directory;
+    bool isDirectory;
+    int len;
+
+    last[0] = '\0';
+    while (*name != '\0') {
+	while (*name == '/')
+	    name++;
+	if (*name == '\0')
+	    break;
+	if (last[0] != '\0') {		// "last" is a directory on the way
+	    directory = new Directory(dirSector);
+	    if (strcmp(last, "..") == 0)
+		dirSector = directory->Parent();
+	    else if (strcmp(last, ".") != 0) {
+		dirSector = directory->Find(last, &isDirectory);
+		if (dirSector != -1 && !isDirectory)
+		    dirSector = -1;	// it is a file
+	    }
+	    delete directory;
+	    if (dirSector == -1)
+		return -1;
+	}
+	for (len = 0; name[len] != '/' && name[len] != '\0'; len++)
+	    ;
+	strncpy(last, name, min(len, FileNameMaxLen));
+	last[min(len, FileNameMaxLen)] = '\0';
+	name += len;
+    }
+    if (strcmp(last, ".") == 0 || strcmp(last, "..") == 0)
+	return -1;
+    return dirSector;
+}
+
 //----------------------------------------------------------------------
 // FileSystem::Create
 // 	Create a file in the Nachos file system (similar to UNIX create).
 //	Since we can't increase the size of files dynamically, we have
 //	to give Create the initial size of the file.
 //
+//	"name" -- path of file to be created
+//	"initialSize" -- size of file to be created
+//----------------------------------------------------------------------
+
+bool
+FileSystem::Create(char *name, int initialSize)
+{
+    DEBUG(dbgFile, "Creating file " << name << " size " << initialSize);
+    return CreateFile(name, initialSize, FALSE);
+}
+
+//----------------------------------------------------------------------
+// FileSystem::Mkdir
+// 	Create an empty directory in the Nachos file system (similar to
+//	UNIX mkdir).
+//
+//	"name" -- path of directory to be created
+//----------------------------------------------------------------------
+
+bool
+FileSystem::Mkdir(char *name)
+{
+    DEBUG(dbgFile, "Creating directory " << name);
+    return CreateFile(name, Directory::FileSize(NumDirEntries), TRUE);
+}
+
+//----------------------------------------------------------------------
+// FileSystem::CreateFile
+// 	Create a file, or a directory, in the Nachos file system.
+//
 //	The steps to create a file are:
+//	  Find the directory it goes in
 //	  Make sure the file doesn't already exist
-//        Allocate a sector for the file header
+//        Pick a cylinder group, and allocate a sector in it for the
+//	    file header
 // 	  Allocate space on disk for the data blocks for the file
-//	  Add the name to the directory
 //	  Store the new file header on disk 
-//	  Flush the changes to the bitmap and the directory back to disk
+//	  If it is a directory, write an empty directory into it
+//	  Add the name to the directory
+//	  Flush the changes to the bitmap back to disk
+//
+//	A file goes in its directory's cylinder group if it fits, so
+//	that a directory and its files are close together on disk; a
+//	new directory goes in the emptiest group, to leave room for the
+//	files that will be put in it.
 //
 //	Return TRUE if everything goes ok, otherwise, return FALSE.
 //
 // 	Create fails if:
+//		a directory on the path does not exist
 //   		file is already in directory
 //	 	no free space for file header
-//	 	no free entry for file in directory
 //	 	no free space for data blocks for the file 
+//	 	no room for the file in the directory, nor for making the
+//		  directory bigger
 //
 // 	Note that this implementation assumes there is no concurrent access
 //	to the file system!
 //
-//	"name" -- name of file to be created
+//	"name" -- path of file to be created
 //	"initialSize" -- size of file to be created
+//	"isDirectory" -- should the file be a directory?
 //----------------------------------------------------------------------
 
 bool
-FileSystem::Create(char *name, int initialSize)
+FileSystem::CreateFile(char *name, int initialSize, bool isDirectory)
 {
-    Directory *directory;
+    Directory *directory, *newDirectory;
     PersistentBitmap *freeMap;
     FileHeader *hdr;
-    int sector;
+    char last[FileNameMaxLen + 1];
+    int dirSector, sector, group;
     bool success;
 
-    DEBUG(dbgFile, "Creating file " << name << " size " << initialSize);
-
-    directory = new Directory(NumDirEntries);
-    directory->FetchFrom(directoryFile);
+    dirSector = FindParent(name, last);
+    if (dirSector == -1 || last[0] == '\0')
+	return FALSE;			// no such directory, or the root
 
-    if (directory->Find(name) != -1)
+    directory = new Directory(dirSector);
+    if (directory->Find(last) != -1)
       success = FALSE;			// file is already in directory
     else {	
         freeMap = new PersistentBitmap(freeMapFile,NumSectors);
-        sector = freeMap->FindAndSet();	// find a sector to hold the file header
+	if (isDirectory)
+	    group = CylinderGroups::EmptiestGroup(freeMap);
+	else
+	    group = CylinderGroups::PickGroup(freeMap,
+			CylinderGroups::GroupOf(dirSector),
+			1 + divRoundUp(initialSize, SectorSize));
+        sector = CylinderGroups::FindAndSet(freeMap, group);
+					// find a sector to hold the file header
     	if (sector == -1) 		
             success = FALSE;		// no free block for file header 
-        else if (!directory->Add(name, sector))
-            success = FALSE;	// no space in directory
 	else {
     	    hdr = new FileHeader;
-	    if (!hdr->Allocate(freeMap, initialSize))
+	    if (!hdr->Allocate(freeMap, initialSize, group))
             	success = FALSE;	// no space on disk for data
 	    else {	
-	    	success = TRUE;
-		// everthing worked, flush all changes back to disk
     	    	hdr->WriteBack(sector); 		
-    	    	directory->WriteBack(directoryFile);
-    	    	freeMap->WriteBack(freeMapFile);
+		if (isDirectory) {
+		    newDirectory = new Directory(sector);
+		    newDirectory->Initialize(NumDirEntries, dirSector);
+		    delete newDirectory;
+		}
+		success = directory->Add(last, sector, isDirectory, freeMap);
+		if (success)	// everthing worked, flush the bitmap to disk
+    	    	    freeMap->WriteBack(freeMapFile);
 	    }
             delete hdr;
 	}
@@ -217,56 +325,74 @@ FileSystem::Create(char *name, int initialSize)
 // FileSystem::Open
 // 	Open a file for reading and writing.  
 //	To open a file:
-//	  Find the location of the file's header, using the directory 
+//	  Find the location of the file's header, using the directories
+//	    along its path
 //	  Bring the header into memory
 //
-//	"name" -- the text name of the file to be opened
+//	"name" -- the path of the file to be opened
 //----------------------------------------------------------------------
 
 OpenFile* FileSystem::Open(char *name)
 { 
-    Directory *directory = new Directory(NumDirEntries);
+    Directory *directory;
     OpenFile *openFile = NULL;
+    char last[FileNameMaxLen + 1];
     int sector;
 
     DEBUG(dbgFile, "Opening file" << name);
-    directory->FetchFrom(directoryFile);
-    sector = directory->Find(name); 
+    sector = FindParent(name, last);
+    if (sector >= 0 && last[0] != '\0') {
+	directory = new Directory(sector);
+	sector = directory->Find(last); 
+	delete directory;
+    }
     if (sector >= 0) 		
 	openFile = new OpenFile(sector);	// name was found in directory 
-    delete directory;
     return openFile;				// return NULL if not found
 }
 
 //----------------------------------------------------------------------
 // FileSystem::Remove
 // 	Delete a file from the file system.  This requires:
-//	    Remove it from the directory
+//	    Remove it from its directory
 //	    Delete the space for its header
 //	    Delete the space for its data blocks
-//	    Write changes to directory, bitmap back to disk
+//	    Write changes to the bitmap back to disk
 //
 //	Return TRUE if the file was deleted, FALSE if the file wasn't
-//	in the file system.
+//	in the file system, or is a directory that is not empty.
 //
-//	"name" -- the text name of the file to be removed
+//	"name" -- the path of the file to be removed
 //----------------------------------------------------------------------
 
 bool
 FileSystem::Remove(char *name)
 { 
-    Directory *directory;
+    Directory *directory, *subDirectory;
     PersistentBitmap *freeMap;
     FileHeader *fileHdr;
-    int sector;
+    char last[FileNameMaxLen + 1];
+    int dirSector, sector;
+    bool isDirectory, isEmpty;
     
-    directory = new Directory(NumDirEntries);
-    directory->FetchFrom(directoryFile);
-    sector = directory->Find(name);
+    dirSector = FindParent(name, last);
+    if (dirSector == -1 || last[0] == '\0')
+	return FALSE;			// no such directory, or the root
+    directory = new Directory(dirSector);
+    sector = directory->Find(last, &isDirectory);
     if (sector == -1) {
        delete directory;
        return FALSE;			 // file not found 
     }
+    if (isDirectory) {
+	subDirectory = new Directory(sector);
+	isEmpty = subDirectory->IsEmpty();
+	delete subDirectory;
+	if (!isEmpty) {
+	    delete directory;
+	    return FALSE;		// directory still has files in it
+	}
+    }
     fileHdr = new FileHeader;
     fileHdr->FetchFrom(sector);
 
@@ -274,10 +400,9 @@ FileSystem::Remove(char *name)
 
     fileHdr->Deallocate(freeMap);  		// remove data blocks
     freeMap->Clear(sector);			// remove header block
-    directory->Remove(name);
+    directory->Remove(last);			// flushed to disk as it goes
 
     freeMap->WriteBack(freeMapFile);		// flush to disk
-    directory->WriteBack(directoryFile);        // flush to disk
     delete fileHdr;
     delete directory;
     delete freeMap;
@@ -286,16 +411,16 @@ FileSystem::Remove(char *name)
 
 //----------------------------------------------------------------------
 // FileSystem::List
-// 	List all the files in the file system directory.
+// 	List all the files in the file system, starting at the root
+//	directory.
 //----------------------------------------------------------------------
 
 void
 FileSystem::List()
 {
-    Directory *directory = new Directory(NumDirEntries);
+    Directory *directory = new Directory(DirectorySector);
 
-    directory->FetchFrom(directoryFile);
-    directory->List();
+    directory->List(0);
     delete directory;
 }
 
@@ -303,8 +428,8 @@ FileSystem::List()
 // FileSystem::Print
 // 	Print everything about the file system:
 //	  the contents of the bitmap
-//	  the contents of the directory
-//	  for each file in the directory,
+//	  the contents of the directories
+//	  for each file in each directory,
 //	      the contents of the file header
 //	      the data in the file
 //----------------------------------------------------------------------
@@ -315,7 +440,7 @@ FileSystem::Print()
     FileHeader *bitHdr = new FileHeader;
     FileHeader *dirHdr = new FileHeader;
     PersistentBitmap *freeMap = new PersistentBitmap(freeMapFile,NumSectors);
-    Directory *directory = new Directory(NumDirEntries);
+    Directory *directory = new Directory(DirectorySector);
 
     printf("Bit map file header:\n");
     bitHdr->FetchFrom(FreeMapSector);
@@ -327,7 +452,6 @@ FileSystem::Print()
 
     freeMap->Print();
 
-    directory->FetchFrom(directoryFile);
     directory->Print();
 
     delete bitHdr;
@@ -18,9 +18,9 @@
 //	file system (in a file named "DISK"). 
 //
 //	In the "real" implementation, there are two key data structures used 
-//	in the file system.  There is a single "root" directory, listing
-//	all of the files in the file system; unlike UNIX, the baseline
-//	system does not provide a hierarchical directory structure.  
+//	in the file system.  There is a "root" directory, listing the
+//	files at the top of the file system; as in UNIX, an entry can
+//	name another directory, and files are named by paths like "a/b/c".
 //	In addition, there is a bitmap for allocating
 //	disk sectors.  Both the root directory and the bitmap are themselves
 //	stored as files in the Nachos file system -- this causes an interesting
@@ -78,17 +78,25 @@ class FileSystem {
 
     OpenFile* Open(char *name); 	// Open a file (UNIX open)
 
-    bool Remove(char *name);  		// Delete a file (UNIX unlink)
+    bool Remove(char *name);  		// Delete a file (UNIX unlink), or
+					// an empty directory (UNIX rmdir)
 
-    void List();			// List all the files in the file system
+    bool Mkdir(char *name);		// Create a directory (UNIX mkdir)
+
+    void List();			// List all the files in the file system,
+					// directory by directory
 
     void Print();			// List all the files and their contents
 
   private:
    OpenFile* freeMapFile;		// Bit map of free disk blocks,
 					// represented as a file
-   OpenFile* directoryFile;		// "Root" directory -- list of 
-					// file names, represented as a file
+
+   bool CreateFile(char *name, int initialSize, bool isDirectory);
+					// Create a file or a directory
+   int FindParent(char *name, char *last);
+					// Find the directory holding the
+					// file "name", and its last component
 };
 
 #endif // FILESYS
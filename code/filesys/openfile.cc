@@ -16,7 +16,7 @@
 #include "main.h"
 #include "filehdr.h"
 #include "openfile.h"
-#include "synchdisk.h"
+#include "sectorcache.h"
 
 //----------------------------------------------------------------------
 // OpenFile::OpenFile
@@ -96,14 +96,18 @@ OpenFile::Write(char *into, int numBytes)
 //	boundary; however the disk only knows how to read/write a whole disk
 //	sector at a time.  Thus:
 //
+//	The full sectors of the request are transferred straight between
+//	the disk and the caller's buffer, each run of them that is
+//	contiguous on disk in a single request.  Only the partial sectors
+//	at either end go through a sector-sized buffer on the stack:
+//
 //	For ReadAt:
-//	   We read in all of the full or partial sectors that are part of the
-//	   request, but we only copy the part we are interested in.
+//	   We read in the partial sector, but we only copy the part we
+//	   are interested in.
 //	For WriteAt:
-//	   We must first read in any sectors that will be partially written,
-//	   so that we don't overwrite the unmodified portion.  We then copy
-//	   in the data that will be modified, and write back all the full
-//	   or partial sectors that are part of the request.
+//	   We must first read in the partial sector, so that we don't
+//	   overwrite the unmodified portion.  We then copy in the data
+//	   that will be modified, and write the sector back.
 //
 //	"into" -- the buffer to contain the data to be read from disk 
 //	"from" -- the buffer containing the data to be written to disk 
@@ -115,8 +119,8 @@ OpenFile::Write(char *into, int numBytes)
 int OpenFile::ReadAt(char *into, int numBytes, int position)
 {
     int fileLength = hdr->FileLength();
-    int i, firstSector, lastSector, numSectors;
-    char *buf;
+    int done, offset, count, sector;
+    char buf[SectorSize];
 
     if ((numBytes <= 0) || (position >= fileLength))
     	return 0; 				// check request
@@ -124,19 +128,19 @@ int OpenFile::ReadAt(char *into, int numBytes, int position)
         numBytes = fileLength - position;
     DEBUG(dbgFile, "Reading " << numBytes << " bytes at " << position << " from file of length " << fileLength);
 
-    firstSector = divRoundDown(position, SectorSize);
-    lastSector = divRoundDown(position + numBytes - 1, SectorSize);
-    numSectors = 1 + lastSector - firstSector;
-
-    // read in all the full and partial sectors that we need
-    buf = new char[numSectors * SectorSize];
-    for (i = firstSector; i <= lastSector; i++)	
-        kernel->synchDisk->ReadSector(hdr->ByteToSector(i * SectorSize), 
-					&buf[(i - firstSector) * SectorSize]);
-
-    // copy the part we want
-    bcopy(&buf[position - (firstSector * SectorSize)], into, numBytes);
-    delete [] buf;
+    for (done = 0; done < numBytes; done += count) {
+        offset = (position + done) % SectorSize;
+        count = min(SectorSize - offset, numBytes - done);
+        if (count < SectorSize) {		// a partial sector
+            kernel->sectorCache->ReadSector(hdr->ByteToSector(position + done), buf);
+            bcopy(&buf[offset], &into[done], count);
+        } else {				// full sectors
+            count = SectorRun(position + done, (numBytes - done) / SectorSize,
+						&sector);
+            kernel->sectorCache->ReadSector(sector, &into[done], count);
+            count *= SectorSize;
+        }
+    }
     return numBytes;
 }
 
@@ -144,9 +148,8 @@ int
 OpenFile::WriteAt(char *from, int numBytes, int position)
 {
     int fileLength = hdr->FileLength();
-    int i, firstSector, lastSector, numSectors;
-    bool firstAligned, lastAligned;
-    char *buf;
+    int done, offset, count, sector;
+    char buf[SectorSize];
 
     if ((numBytes <= 0) || (position >= fileLength))
 	return 0;				// check request
@@ -154,31 +157,47 @@ OpenFile::WriteAt(char *from, int numBytes, int position)
 	numBytes = fileLength - position;
     DEBUG(dbgFile, "Writing " << numBytes << " bytes at " << position << " from file of length " << fileLength);
 
-    firstSector = divRoundDown(position, SectorSize);
-    lastSector = divRoundDown(position + numBytes - 1, SectorSize);
-    numSectors = 1 + lastSector - firstSector;
-
-    buf = new char[numSectors * SectorSize];
-
-    firstAligned = (position == (firstSector * SectorSize));
-    lastAligned = ((position + numBytes) == ((lastSector + 1) * SectorSize));
+    for (done = 0; done < numBytes; done += count) {
+        offset = (position + done) % SectorSize;
+        count = min(SectorSize - offset, numBytes - done);
+        if (count < SectorSize) {		// read-modify-write
+            sector = hdr->ByteToSector(position + done);
+            kernel->sectorCache->ReadSector(sector, buf);
+            bcopy(&from[done], &buf[offset], count);
+            kernel->sectorCache->WriteSector(sector, buf);
+        } else {				// full sectors
+            count = SectorRun(position + done, (numBytes - done) / SectorSize,
+						&sector);
+            kernel->sectorCache->WriteSector(sector, &from[done], count);
+            count *= SectorSize;
+        }
+    }
+    return numBytes;
+}
 
-// read in first and last sector, if they are to be partially modified
-    if (!firstAligned)
-        ReadAt(buf, SectorSize, firstSector * SectorSize);	
-    if (!lastAligned && ((firstSector != lastSector) || firstAligned))
-        ReadAt(&buf[(lastSector - firstSector) * SectorSize], 
-				SectorSize, lastSector * SectorSize);	
+//----------------------------------------------------------------------
+// OpenFile::SectorRun
+// 	Find how many of the file sectors starting at "position" lie one
+//	after the other on disk, so they can be moved in one request.
+//
+//	"position" -- the offset of the first byte, at a sector boundary
+//	"maxSectors" -- the most sectors wanted, at least 1
+//	"sector" -- set to the disk sector holding "position"
+//
+// Returns:
+//	The number of sectors in the run.
+//----------------------------------------------------------------------
 
-// copy in the bytes we want to change 
-    bcopy(from, &buf[position - (firstSector * SectorSize)], numBytes);
+int
+OpenFile::SectorRun(int position, int maxSectors, int *sector)
+{
+    int count = 1;
 
-// write modified sectors back
-    for (i = firstSector; i <= lastSector; i++)	
-        kernel->synchDisk->WriteSector(hdr->ByteToSector(i * SectorSize), 
-					&buf[(i - firstSector) * SectorSize]);
-    delete [] buf;
-    return numBytes;
+    *sector = hdr->ByteToSector(position);
+    while (count < maxSectors
+	   && hdr->ByteToSector(position + count * SectorSize) == *sector + count)
+	count++;
+    return count;
 }
 
 //----------------------------------------------------------------------
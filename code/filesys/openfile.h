@@ -90,6 +90,10 @@ class OpenFile {
   private:
     FileHeader *hdr;			// Header for this file 
     int seekPosition;			// Current position within the file
+
+    int SectorRun(int position, int maxSectors, int *sector);
+					// How many sectors from "position"
+					// on are contiguous on disk
 };
 
 #endif // FILESYS
@@ -0,0 +1,400 @@
+// sectorcache.cc
+//	Routines for the write-back sector cache.  See sectorcache.h for
+//	the policies.
+//
+//	A single lock serializes the cache, disk I/O included: the disk
+//	only does one request at a time anyway, and holding the lock
+//	means no one can find a sector half read in, or read a sector
+//	from disk while its new contents are still being written out.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+#ifndef FILESYS_STUB
+
+#include "copyright.h"
+#include "sectorcache.h"
+#include "synchdisk.h"
+#include "main.h"
+
+//----------------------------------------------------------------------
+// SectorCache::SectorCache
+// 	Initialize an empty cache, and start the thread that writes the
+//	dirty sectors back every FlushInterval ticks.
+//
+//	"policy" -- LRU or ARC replacement
+//----------------------------------------------------------------------
+
+SectorCache::SectorCache(CachePolicy policy)
+{
+    this->policy = policy;
+    lock = new Lock("sector cache");
+    memory = new char[CacheSectors * SectorSize];
+    staging = new char[CacheSectors * SectorSize];
+    t1 = new IntrusiveList<CacheEntry>(&CacheEntry::link);
+    t2 = new IntrusiveList<CacheEntry>(&CacheEntry::link);
+    b1 = new IntrusiveList<CacheEntry>(&CacheEntry::link);
+    b2 = new IntrusiveList<CacheEntry>(&CacheEntry::link);
+    freeBuffers = new IntrusiveList<CacheEntry>(&CacheEntry::link);
+    freeGhosts = new IntrusiveList<CacheEntry>(&CacheEntry::link);
+    target = 0;
+
+    for (int i = 0; i < CacheBuckets; i++)
+        buckets[i] = NULL;
+    for (int i = 0; i < CacheSectors; i++)
+    {
+        buffers[i].data = &memory[i * SectorSize];
+        freeBuffers->Append(&buffers[i]);
+        freeGhosts->Append(&ghosts[i]);
+    }
+
+    Thread *flusher = new Thread("sector flusher");
+    flusher->Fork(SectorCache::Flusher, this);
+}
+
+//----------------------------------------------------------------------
+// SectorCache::~SectorCache
+// 	De-allocate the cache.  Anything still dirty should have been
+//	written back by a Sync when the machine halted.
+//----------------------------------------------------------------------
+
+SectorCache::~SectorCache()
+{
+    delete t1;
+    delete t2;
+    delete b1;
+    delete b2;
+    delete freeBuffers;
+    delete freeGhosts;
+    delete [] memory;
+    delete [] staging;
+    delete lock;
+}
+
+//----------------------------------------------------------------------
+// SectorCache::Lookup, HashInsert, HashRemove
+// 	Maintain the hash table of the sectors we know about, cached or
+//	ghosts.
+//----------------------------------------------------------------------
+
+CacheEntry *SectorCache::Lookup(int sector)
+{
+    CacheEntry *entry = buckets[sector & (CacheBuckets - 1)];
+
+    while (entry != NULL && entry->sector != sector)
+        entry = entry->hashNext;
+    return entry;
+}
+
+void SectorCache::HashInsert(CacheEntry *entry)
+{
+    CacheEntry **bucket = &buckets[entry->sector & (CacheBuckets - 1)];
+
+    entry->hashNext = *bucket;
+    *bucket = entry;
+}
+
+void SectorCache::HashRemove(CacheEntry *entry)
+{
+    CacheEntry **ptr = &buckets[entry->sector & (CacheBuckets - 1)];
+
+    while (*ptr != entry)
+        ptr = &(*ptr)->hashNext;
+    *ptr = entry->hashNext;
+    entry->hashNext = NULL;
+}
+
+//----------------------------------------------------------------------
+// SectorCache::ListOf, MoveTo
+// 	Find the list an entry is on, and move it to the most recently
+//	used end of a list.
+//----------------------------------------------------------------------
+
+IntrusiveList<CacheEntry> *SectorCache::ListOf(CacheEntry *entry)
+{
+    switch (entry->list)
+    {
+    case CacheT1:
+        return t1;
+    case CacheT2:
+        return t2;
+    case CacheB1:
+        return b1;
+    case CacheB2:
+        return b2;
+    default:
+        return entry->data != NULL ? freeBuffers : freeGhosts;
+    }
+}
+
+void SectorCache::MoveTo(CacheEntry *entry, CacheList which)
+{
+    if (entry->link.IsLinked())
+        ListOf(entry)->Remove(entry);
+    entry->list = which;
+    ListOf(entry)->Append(entry);
+}
+
+//----------------------------------------------------------------------
+// SectorCache::Forget
+// 	Drop a ghost: it has come back into the cache, or it is the
+//	oldest of its list and room is needed.
+//----------------------------------------------------------------------
+
+void SectorCache::Forget(CacheEntry *ghost)
+{
+    HashRemove(ghost);
+    ghost->sector = -1;
+    MoveTo(ghost, CacheFree);
+}
+
+//----------------------------------------------------------------------
+// SectorCache::Evict
+// 	Take the least recently used buffer off list "from", writing it
+//	back first if it is dirty.  ARC remembers the sector it held on
+//	the ghost list that goes with "from".
+//
+// Returns:
+//	The buffer, now free.
+//----------------------------------------------------------------------
+
+CacheEntry *SectorCache::Evict(CacheList from, bool remember)
+{
+    CacheEntry *buffer = ((from == CacheT1) ? t1 : t2)->RemoveFront();
+
+    ASSERT(buffer != NULL);
+    if (buffer->dirty)
+    {
+        kernel->synchDisk->WriteSector(buffer->sector, buffer->data);
+        buffer->dirty = FALSE;
+    }
+    HashRemove(buffer);
+    if (remember)
+    {
+        CacheEntry *ghost = freeGhosts->RemoveFront();
+
+        ASSERT(ghost != NULL);
+        ghost->sector = buffer->sector;
+        HashInsert(ghost);
+        MoveTo(ghost, from == CacheT1 ? CacheB1 : CacheB2);
+    }
+    buffer->sector = -1;
+    buffer->list = CacheFree;
+    return buffer;
+}
+
+//----------------------------------------------------------------------
+// SectorCache::Replace
+// 	ARC's REPLACE: the cache is full, so free a buffer from T1 if it
+//	is bigger than its target (or just as big, when the sector
+//	wanted was a ghost of T2), from T2 otherwise.
+//
+//	"inB2" -- the sector wanted was on B2
+//----------------------------------------------------------------------
+
+CacheEntry *SectorCache::Replace(bool inB2)
+{
+    int n1 = t1->NumInList();
+
+    if (!freeBuffers->IsEmpty())
+        return freeBuffers->RemoveFront();
+    if (n1 > 0 && ((inB2 && n1 == target) || n1 > target || t2->IsEmpty()))
+        return Evict(CacheT1, TRUE);
+    return Evict(CacheT2, TRUE);
+}
+
+//----------------------------------------------------------------------
+// SectorCache::Find
+// 	Return the buffer holding "sector", making room for it and
+//	reading it from disk if it is not cached.  A sector about to be
+//	overwritten whole need not be read ("load" is FALSE).
+//
+//	The cases of ARC are those of the paper: a hit, a ghost of T1
+//	(T1 should have been bigger), a ghost of T2 (T2 should have
+//	been), and a sector we know nothing about.
+//----------------------------------------------------------------------
+
+CacheEntry *SectorCache::Find(int sector, bool load)
+{
+    CacheEntry *entry = Lookup(sector);
+    CacheEntry *buffer;
+    CacheList to = CacheT1;
+
+    if (entry != NULL && entry->data != NULL)
+    {
+        kernel->stats->numCacheHits++;
+        MoveTo(entry, policy == CacheARC ? CacheT2 : CacheT1);
+        return entry;
+    }
+    kernel->stats->numCacheMisses++;
+
+    if (policy == CacheLRU)
+        buffer = freeBuffers->IsEmpty() ? Evict(CacheT1, FALSE)
+                                        : freeBuffers->RemoveFront();
+    else if (entry != NULL)
+    {
+        int n1 = b1->NumInList(), n2 = b2->NumInList();
+        bool inB2 = (entry->list == CacheB2);
+
+        if (inB2)
+            target = max(0, target - max(n2 ? n1 / n2 : 1, 1));
+        else
+            target = min(CacheSectors, target + max(n1 ? n2 / n1 : 1, 1));
+        Forget(entry);
+        buffer = Replace(inB2);
+        to = CacheT2;
+    }
+    else
+    {
+        int l1 = t1->NumInList() + b1->NumInList();
+        int total = l1 + t2->NumInList() + b2->NumInList();
+
+        if (l1 == CacheSectors)
+        {
+            if (t1->NumInList() < CacheSectors)
+            {
+                Forget(b1->RemoveFront());
+                buffer = Replace(FALSE);
+            }
+            else
+                buffer = Evict(CacheT1, FALSE);
+        }
+        else if (total >= CacheSectors)
+        {
+            if (total == 2 * CacheSectors)
+                Forget(b2->RemoveFront());
+            buffer = Replace(FALSE);
+        }
+        else
+            buffer = freeBuffers->RemoveFront();
+    }
+
+    buffer->sector = sector;
+    buffer->dirty = FALSE;
+    HashInsert(buffer);
+    if (load)
+        kernel->synchDisk->ReadSector(sector, buffer->data);
+    MoveTo(buffer, to);
+    return buffer;
+}
+
+//----------------------------------------------------------------------
+// SectorCache::ReadSector
+// 	Copy the contents of "count" consecutive sectors into "data",
+//	from the cache.  Each run of sectors that are not cached is
+//	read from disk straight into "data", in a single request, and
+//	then cached.
+//
+//	"sectorNumber" -- the first disk sector to read
+//	"data" -- the buffer to hold the contents of the disk sectors
+//	"count" -- how many sectors
+//----------------------------------------------------------------------
+
+void SectorCache::ReadSector(int sectorNumber, char *data, int count)
+{
+    int i, j;
+
+    lock->Acquire();
+    for (i = 0; i < count; i = j)
+    {
+        for (j = i; j < count; j++)
+        {
+            CacheEntry *entry = Lookup(sectorNumber + j);
+
+            if (entry != NULL && entry->data != NULL)
+                break;
+        }
+        if (j > i)
+        {
+            kernel->synchDisk->ReadSector(sectorNumber + i,
+                                          &data[i * SectorSize], j - i);
+            for (; i < j; i++)
+                bcopy(&data[i * SectorSize],
+                      Find(sectorNumber + i, FALSE)->data, SectorSize);
+        }
+        else
+        {
+            bcopy(Find(sectorNumber + i, TRUE)->data, &data[i * SectorSize],
+                  SectorSize);
+            j = i + 1;
+        }
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// SectorCache::WriteSector
+// 	Replace the contents of "count" consecutive sectors by "data".
+//	Only the cached copies change; the disk is written later.
+//
+//	"sectorNumber" -- the first disk sector to be written
+//	"data" -- the new contents of the disk sectors
+//	"count" -- how many sectors
+//----------------------------------------------------------------------
+
+void SectorCache::WriteSector(int sectorNumber, char *data, int count)
+{
+    lock->Acquire();
+    for (int i = 0; i < count; i++)
+    {
+        CacheEntry *buffer = Find(sectorNumber + i, FALSE);
+
+        bcopy(&data[i * SectorSize], buffer->data, SectorSize);
+        buffer->dirty = TRUE;
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// SectorCache::Sync
+// 	Write every dirty sector back to disk, in increasing sector
+//	order, so the disk head sweeps across once.  Dirty sectors that
+//	follow each other are copied together and written in one
+//	request.
+//----------------------------------------------------------------------
+
+void SectorCache::Sync()
+{
+    lock->Acquire();
+    for (;;)
+    {
+        CacheEntry *next = NULL, *entry;
+        int count = 0;
+
+        for (int i = 0; i < CacheSectors; i++)
+        {
+            if (buffers[i].dirty && (next == NULL || buffers[i].sector < next->sector))
+                next = &buffers[i];
+        }
+        if (next == NULL)
+            break;
+        for (entry = next; entry != NULL && entry->data != NULL && entry->dirty;
+             entry = Lookup(next->sector + count))
+        {
+            bcopy(entry->data, &staging[count * SectorSize], SectorSize);
+            entry->dirty = FALSE;
+            count++;
+        }
+        kernel->synchDisk->WriteSector(next->sector, staging, count);
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// SectorCache::Flusher
+// 	The flusher thread: write the dirty sectors back every
+//	FlushInterval ticks, so not much is lost if Nachos dies.
+//----------------------------------------------------------------------
+
+void SectorCache::Flusher(void *arg)
+{
+    SectorCache *cache = (SectorCache *)arg;
+
+    for (;;)
+    {
+        kernel->alarm->WaitUntil(FlushInterval);
+        cache->Sync();
+    }
+}
+
+#endif // FILESYS_STUB
@@ -0,0 +1,115 @@
+// sectorcache.h
+//	Data structures for a write-back cache of disk sectors, between
+//	the file system (OpenFile, FileHeader) and the SynchDisk.
+//
+//	Reads are served from memory when the sector is cached.  Writes
+//	only update the cached copy and mark it dirty; it goes to disk
+//	when it is evicted, when the flusher thread wakes up (every
+//	FlushInterval ticks), or on an explicit Sync -- at the latest
+//	when the machine halts.  A Sync writes each run of consecutive
+//	dirty sectors in a single disk request.
+//
+//	Two replacement policies are provided.  LRU keeps one list of
+//	the cached sectors, most recently used last.  ARC (Megiddo and
+//	Modha's Adaptive Replacement Cache) splits it into T1, sectors
+//	used once lately, and T2, sectors used at least twice, and
+//	remembers the numbers of sectors recently evicted from each
+//	(the "ghost" lists B1 and B2).  A miss that hits a ghost tells
+//	which list should have been bigger, and the target size of T1
+//	is moved that way, so a scan through a big file does not flush
+//	out the directory and the free map.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef SECTORCACHE_H
+#define SECTORCACHE_H
+
+#include "copyright.h"
+#include "ilist.h"
+#include "disk.h"
+
+class Lock;
+
+#define CacheSectors	64		// sectors kept in memory
+#define CacheBuckets	64		// hash table size, a power of 2
+#define FlushInterval	100000		// ticks between flusher runs
+
+enum CachePolicy { CacheLRU, CacheARC };
+
+// Which list a cache entry is on.
+enum CacheList { CacheFree, CacheT1, CacheT2, CacheB1, CacheB2 };
+
+// A cached sector, or (with no data) a ghost: a sector ARC evicted
+// lately, remembered by number only.
+
+class CacheEntry {
+  public:
+    CacheEntry() : link(this) { sector = -1; dirty = FALSE;
+				data = NULL; list = CacheFree; hashNext = NULL; }
+
+    int sector;			// which sector, -1 if unused
+    bool dirty;			// changed since read from disk?
+    char *data;			// its contents; NULL for a ghost
+    CacheList list;		// the list we are on
+    ListLink<CacheEntry> link;	// on that list, least recently used
+				// first
+    CacheEntry *hashNext;	// next entry in the same hash bucket
+};
+
+class SectorCache {
+  public:
+    SectorCache(CachePolicy policy);
+				// empty cache, with a flusher thread
+    ~SectorCache();		// write back, and de-allocate
+
+    void ReadSector(int sectorNumber, char *data, int count = 1);
+				// copy "count" consecutive sectors out
+				// of the cache, reading each run of
+				// misses from disk in one request
+    void WriteSector(int sectorNumber, char *data, int count = 1);
+				// copy sectors into the cache; they
+				// are written to disk later
+    void Sync();		// write every dirty sector to disk
+
+  private:
+    CachePolicy policy;
+    Lock *lock;			// one cache operation at a time
+    CacheEntry buffers[CacheSectors];	// the cached sectors
+    CacheEntry ghosts[CacheSectors];	// for B1 and B2
+    char *memory;		// the data of all the buffers
+    char *staging;		// Sync gathers runs of dirty sectors
+				// here, to write each in one request
+    CacheEntry *buckets[CacheBuckets];	// cached and ghost sectors,
+				// hashed by sector number
+
+    IntrusiveList<CacheEntry> *t1, *t2, *b1, *b2;
+    IntrusiveList<CacheEntry> *freeBuffers, *freeGhosts;
+    int target;			// ARC: the size T1 should have
+
+    CacheEntry *Lookup(int sector);
+    void HashInsert(CacheEntry *entry);
+    void HashRemove(CacheEntry *entry);
+    IntrusiveList<CacheEntry> *ListOf(CacheEntry *entry);
+				// the list "entry" is on
+    void MoveTo(CacheEntry *entry, CacheList which);
+				// make "entry" the most recently used
+				// of list "which"
+    void Forget(CacheEntry *ghost);
+				// drop a ghost
+    CacheEntry *Evict(CacheList from, bool remember);
+				// write back and free the LRU buffer of
+				// "from", remembering it as a ghost if
+				// asked to
+    CacheEntry *Replace(bool inB2);
+				// ARC: free a buffer, from T1 or T2
+    CacheEntry *Find(int sector, bool load);
+				// the buffer for "sector", read from
+				// disk on a miss if "load"
+
+    static void Flusher(void *arg);
+				// body of the flusher thread
+};
+
+#endif // SECTORCACHE_H
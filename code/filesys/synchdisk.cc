@@ -47,36 +47,38 @@ SynchDisk::~SynchDisk()
 
 //----------------------------------------------------------------------
 // SynchDisk::ReadSector
-// 	Read the contents of a disk sector into a buffer.  Return only
-//	after the data has been read.
+// 	Read the contents of "count" consecutive disk sectors into a
+//	buffer.  Return only after the data has been read.
 //
-//	"sectorNumber" -- the disk sector to read
-//	"data" -- the buffer to hold the contents of the disk sector
+//	"sectorNumber" -- the first disk sector to read
+//	"data" -- the buffer to hold the contents of the disk sectors
+//	"count" -- how many sectors
 //----------------------------------------------------------------------
 
 void
-SynchDisk::ReadSector(int sectorNumber, char* data)
+SynchDisk::ReadSector(int sectorNumber, char* data, int count)
 {
     lock->Acquire();			// only one disk I/O at a time
-    disk->ReadRequest(sectorNumber, data);
+    disk->ReadRequest(sectorNumber, data, count);
     semaphore->P();			// wait for interrupt
     lock->Release();
 }
 
 //----------------------------------------------------------------------
 // SynchDisk::WriteSector
-// 	Write the contents of a buffer into a disk sector.  Return only
-//	after the data has been written.
+// 	Write the contents of a buffer into "count" consecutive disk
+//	sectors.  Return only after the data has been written.
 //
-//	"sectorNumber" -- the disk sector to be written
-//	"data" -- the new contents of the disk sector
+//	"sectorNumber" -- the first disk sector to be written
+//	"data" -- the new contents of the disk sectors
+//	"count" -- how many sectors
 //----------------------------------------------------------------------
 
 void
-SynchDisk::WriteSector(int sectorNumber, char* data)
+SynchDisk::WriteSector(int sectorNumber, char* data, int count)
 {
     lock->Acquire();			// only one disk I/O at a time
-    disk->WriteRequest(sectorNumber, data);
+    disk->WriteRequest(sectorNumber, data, count);
     semaphore->P();			// wait for interrupt
     lock->Release();
 }
@@ -32,13 +32,15 @@ class SynchDisk : public CallBackObj {
 					// by initializing the raw Disk.
     ~SynchDisk();			// De-allocate the synch disk data
     
-    void ReadSector(int sectorNumber, char* data);
-    					// Read/write a disk sector, returning
-    					// only once the data is actually read 
-					// or written.  These call
-    					// Disk::ReadRequest/WriteRequest and
-					// then wait until the request is done.
-    void WriteSector(int sectorNumber, char* data);
+    void ReadSector(int sectorNumber, char* data, int count = 1);
+    					// Read/write "count" consecutive disk
+					// sectors, returning only once the
+					// data is actually read or written.
+					// These call Disk::ReadRequest/
+					// WriteRequest (one request for all
+					// of them) and then wait until the
+					// request is done.
+    void WriteSector(int sectorNumber, char* data, int count = 1);
     
     void CallBack();			// Called by the disk device interrupt
 					// handler, to signal that the
@@ -119,6 +119,64 @@ Bitmap::FindAndSet()
     return -1;
 }
 
+//----------------------------------------------------------------------
+// Bitmap::FindAndSetRun
+// 	Find a run of consecutive clear bits, and set up to "length" of
+//	them.  The run chosen is the shortest one that has "length" bits
+//	(best fit, so big runs are kept for big requests); if none is that
+//	long, it is the longest there is.
+//
+//	Return the number of the first bit set, and the number of bits
+//	set in "found".  If no bits are clear, return -1.
+//
+//	"length" is how many bits are wanted
+//	"found" is set to how many bits were set
+//----------------------------------------------------------------------
+
+int
+Bitmap::FindAndSetRun(int length, int *found)
+{
+    int start = FindRun(length, found, 0, numBits);
+
+    for (int i = start; i < start + *found; i++)
+	Mark(i);
+    return start;
+}
+
+//----------------------------------------------------------------------
+// Bitmap::FindRun
+// 	Find a run of clear bits as FindAndSetRun does, but only among
+//	bits "from" to "to" - 1, and leave the bits clear.
+//
+//	Return the number of the first bit of the run, and in "found"
+//	how many bits of it (at most "length") are wanted.  If no bits
+//	in the range are clear, return -1.
+//----------------------------------------------------------------------
+
+int
+Bitmap::FindRun(int length, int *found, int from, int to) const
+{
+    int best = -1, bestLength = 0;
+    int start, i;
+
+    ASSERT(length > 0 && from >= 0 && to <= numBits);
+    i = from;
+    while (i < to) {
+	for (start = i; start < to && Test(start); start++)
+	    ;				// skip the bits in use
+	for (i = start; i < to && !Test(i); i++)
+	    ;				// and count the clear ones
+	if ((i > start) && ((i - start >= length)
+		? (bestLength < length || i - start < bestLength)
+		: (i - start > bestLength))) {
+	    best = start;
+	    bestLength = i - start;
+	}
+    }
+    *found = min(length, bestLength);
+    return best;
+}
+
 //----------------------------------------------------------------------
 // Bitmap::NumClear
 // 	Return the number of clear bits in the bitmap.
@@ -184,4 +242,17 @@ void Bitmap::SelfTest()
     for (i = 0; i < numBits; i++) {
         Clear(i);
     }
+
+    int found;
+
+    Mark(2);				// runs of 2 and numBits - 3
+    ASSERT(FindAndSetRun(2, &found) == 0 && found == 2);
+    Clear(0);
+    Clear(1);
+    ASSERT(FindAndSetRun(numBits, &found) == 3 && found == numBits - 3);
+    ASSERT(FindAndSetRun(4, &found) == 0 && found == 2);
+    ASSERT(FindAndSetRun(1, &found) == -1 && found == 0);
+    for (i = 0; i < numBits; i++) {
+        Clear(i);
+    }
 }
@@ -42,6 +42,13 @@ class Bitmap {
     int FindAndSet();         // Return the # of a clear bit, and as a side
 				// effect, set the bit. 
 				// If no bits are clear, return -1.
+    int FindAndSetRun(int length, int *found);
+				// Set the bits of a run of clear bits,
+				// at most "length" of them; return the
+				// first, and how many in "found"
+    int FindRun(int length, int *found, int from, int to) const;
+				// The same, without setting them, only
+				// looking at bits "from" to "to" - 1
     int NumClear() const;	// Return the number of clear bits
 
     void Print() const;		// Print contents of bitmap
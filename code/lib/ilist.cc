@@ -0,0 +1,225 @@
+// ilist.cc
+//     	Routines to manage an intrusive doubly linked list of "things".
+//
+//	The links live in the items themselves (see ilist.h), so none of
+//	these routines allocates or frees memory.
+//
+//     	NOTE: Mutual exclusion must be provided by the caller.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+
+//----------------------------------------------------------------------
+// IntrusiveList<T>::IntrusiveList
+//	Initialize a list, empty to start with.
+//
+//	"link" is the ListLink member of T used to link the items.
+//----------------------------------------------------------------------
+
+template <class T>
+IntrusiveList<T>::IntrusiveList(ListLink<T> T::*link)
+{
+    this->link = link;
+    first = last = NULL;
+    numInList = 0;
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList<T>::~IntrusiveList
+//	Prepare a list for deallocation.  Like List, this does *NOT*
+//	free the items; normally, the list should be empty when this is
+//	called.
+//----------------------------------------------------------------------
+
+template <class T>
+IntrusiveList<T>::~IntrusiveList()
+{
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList<T>::Prepend, Append
+//      Put an item at the beginning or at the end of the list.
+//
+//	"item" is the thing to put on the list; it must not be on any
+//	list through the same link.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+IntrusiveList<T>::Prepend(T *item)
+{
+    ListLink<T> *element = &(item->*link);
+
+    ASSERT(element->list == NULL);
+    element->list = this;
+    element->prev = NULL;
+    element->next = first;
+    if (first == NULL)
+        last = element;
+    else
+        first->prev = element;
+    first = element;
+    numInList++;
+}
+
+template <class T>
+void
+IntrusiveList<T>::Append(T *item)
+{
+    ListLink<T> *element = &(item->*link);
+
+    ASSERT(element->list == NULL);
+    element->list = this;
+    element->next = NULL;
+    element->prev = last;
+    if (last == NULL)
+        first = element;
+    else
+        last->next = element;
+    last = element;
+    numInList++;
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList<T>::Insert
+//      Insert an item into a list kept sorted by "compare", after all
+//	the items that do not compare bigger.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+IntrusiveList<T>::Insert(T *item, int (*compare)(T *x, T *y))
+{
+    ListLink<T> *element = &(item->*link);
+    ListLink<T> *ptr;
+
+    for (ptr = first; ptr != NULL; ptr = ptr->next) {
+        if (compare(item, ptr->item) < 0)
+            break;
+    }
+    if (ptr == NULL) {
+        Append(item);
+        return;
+    }
+    if (ptr == first) {
+        Prepend(item);
+        return;
+    }
+    ASSERT(element->list == NULL);
+    element->list = this;
+    element->prev = ptr->prev;
+    element->next = ptr;
+    ptr->prev->next = element;
+    ptr->prev = element;
+    numInList++;
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList<T>::Remove
+//      Take "item" off the list.  The item must be on this list.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+IntrusiveList<T>::Remove(T *item)
+{
+    ListLink<T> *element = &(item->*link);
+
+    ASSERT(element->list == this);
+    if (element->prev == NULL)
+        first = element->next;
+    else
+        element->prev->next = element->next;
+    if (element->next == NULL)
+        last = element->prev;
+    else
+        element->next->prev = element->prev;
+    element->prev = element->next = NULL;
+    element->list = NULL;
+    numInList--;
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList<T>::Next
+//      Step through a list: return the item after "item", which must
+//	be on this list, or NULL if it is the last one.
+//----------------------------------------------------------------------
+
+template <class T>
+T *
+IntrusiveList<T>::Next(T *item)
+{
+    ListLink<T> *element = &(item->*link);
+
+    ASSERT(element->list == this);
+    return element->next == NULL ? NULL : element->next->item;
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList<T>::RemoveFront
+//      Remove the first item from the front of the list.
+//
+// Returns:
+//	The removed item, or NULL if the list is empty.
+//----------------------------------------------------------------------
+
+template <class T>
+T *
+IntrusiveList<T>::RemoveFront()
+{
+    T *item;
+
+    if (first == NULL)
+        return NULL;
+    item = first->item;
+    Remove(item);
+    return item;
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList<T>::Splice
+//      Move every item of "other" to the end of this list, keeping
+//	their order.  Only the items' back pointers to their list are
+//	touched one by one; no links are taken apart.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+IntrusiveList<T>::Splice(IntrusiveList<T> *other)
+{
+    ASSERT(other->link == link);
+    if (other->IsEmpty())
+        return;
+    for (ListLink<T> *ptr = other->first; ptr != NULL; ptr = ptr->next)
+        ptr->list = this;
+    other->first->prev = last;
+    if (last == NULL)
+        first = other->first;
+    else
+        last->next = other->first;
+    last = other->last;
+    numInList += other->numInList;
+    other->first = other->last = NULL;
+    other->numInList = 0;
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList<T>::Apply
+//      Apply function to every item on a list.
+//
+//	"func" -- the function to apply
+//----------------------------------------------------------------------
+
+template <class T>
+void
+IntrusiveList<T>::Apply(void (*func)(T *))
+{
+    ListLink<T> *ptr;
+
+    for (ptr = first; ptr != NULL; ptr = ptr->next) {
+        (*func)(ptr->item);
+    }
+}
@@ -0,0 +1,96 @@
+// ilist.h
+//	Data structures to manage intrusive doubly linked lists.
+//
+//	Unlike List, an intrusive list does not allocate a cell for each
+//	item: the links are a ListLink member of the item itself, and
+//	the list is told which member to use when it is created.  So
+//	putting an item on a list never calls new, and taking a given
+//	item off a list is O(1) instead of a walk.
+//
+//	An item can be on as many lists at once as it has ListLink
+//	members, but on at most one list per link.  Thread, for example,
+//	has one link for the ready queue or the wait queue it is on, and
+//	another for the scheduler's list of blocked threads.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef ILIST_H
+#define ILIST_H
+
+#include "copyright.h"
+#include "debug.h"
+
+template <class T> class IntrusiveList;
+
+// The links that put an object of type T on an IntrusiveList<T>.
+// "owner" is the object the link is embedded in.
+
+template <class T>
+class ListLink {
+  public:
+    ListLink(T *owner) { item = owner; prev = next = NULL; list = NULL; }
+
+    bool IsLinked() { return list != NULL; }
+				// is the owner on a list, through
+				// this link?
+
+  private:
+    T *item;			// the object this link is part of
+    ListLink<T> *prev;		// neighbours on the list, NULL at the ends
+    ListLink<T> *next;
+    IntrusiveList<T> *list;	// the list we are on, or NULL
+
+    friend class IntrusiveList<T>;
+};
+
+// The following class defines an intrusive list of T's, linked
+// through the ListLink member "link" of each T.  Items are added
+// and removed in O(1), except for Insert, which keeps the list sorted
+// and so walks it.
+
+template <class T>
+class IntrusiveList {
+  public:
+    IntrusiveList(ListLink<T> T::*link);
+				// initialize the list, linked through
+				// the member "link" of its items
+    ~IntrusiveList();		// de-allocate the list
+
+    void Prepend(T *item);	// Put item at the beginning of the list
+    void Append(T *item);	// Put item at the end of the list
+    void Insert(T *item, int (*compare)(T *x, T *y));
+				// Put item before the first item that
+				// is bigger, so items that compare equal
+				// stay in FIFO order
+
+    T *Front() { return first->item; }
+    				// Return first item on list
+				// without removing it
+    T *Next(T *item);		// the item after "item", or NULL
+    T *RemoveFront();		// Take item off the front of the list
+    void Remove(T *item);	// Remove specific item from list; O(1)
+    void Splice(IntrusiveList<T> *other);
+				// Move all of "other" to the end of
+				// this list
+
+    bool IsInList(T *item) { return (item->*link).list == this; }
+				// is the item in the list?  O(1)
+
+    unsigned int NumInList() { return numInList; }
+    bool IsEmpty() { return numInList == 0; }
+
+    void Apply(void (*f)(T *));	// apply function to all elements in list
+
+  private:
+    ListLink<T> T::*link;	// which member of T links it in
+    ListLink<T> *first;		// Head of the list, NULL if list is empty
+    ListLink<T> *last;		// Last element of list
+    int numInList;		// number of elements in list
+};
+
+#include "ilist.cc"		// templates are really like macros
+				// so needs to be included in every
+				// file that uses the template
+#endif // ILIST_H
@@ -97,7 +97,7 @@ PrintSector (bool writing, int sector, char *data)
 
 //----------------------------------------------------------------------
 // Disk::ReadRequest/WriteRequest
-// 	Simulate a request to read/write a single disk sector
+// 	Simulate a request to read/write "count" consecutive disk sectors
 //	   Do the read/write immediately to the UNIX file
 //	   Set up an interrupt handler to be called later,
 //	      that will notify the caller when the simulator says
@@ -106,46 +106,51 @@ PrintSector (bool writing, int sector, char *data)
 //	Note that a disk only allows an entire sector to be read/written,
 //	not part of a sector.
 //
-//	"sectorNumber" -- the disk sector to read/write
+//	"sectorNumber" -- the first disk sector to read/write
 //	"data" -- the bytes to be written, the buffer to hold the incoming bytes
+//	"count" -- how many sectors, 1 by default
 //----------------------------------------------------------------------
 
 void
-Disk::ReadRequest(int sectorNumber, char* data)
+Disk::ReadRequest(int sectorNumber, char* data, int count)
 {
-    int ticks = ComputeLatency(sectorNumber, FALSE);
+    int ticks = RunLatency(sectorNumber, count, FALSE);
 
     ASSERT(!active);				// only one request at a time
-    ASSERT((sectorNumber >= 0) && (sectorNumber < NumSectors));
+    ASSERT((sectorNumber >= 0) && (count > 0)
+				&& (sectorNumber + count <= NumSectors));
     
-    DEBUG(dbgDisk, "Reading from sector " << sectorNumber);
+    DEBUG(dbgDisk, "Reading from sector " << sectorNumber << ", count " << count);
     Lseek(fileno, SectorSize * sectorNumber + MagicSize, 0);
-    Read(fileno, data, SectorSize);
+    Read(fileno, data, SectorSize * count);
     if (debug->IsEnabled('d'))
-	PrintSector(FALSE, sectorNumber, data);
+	for (int i = 0; i < count; i++)
+	    PrintSector(FALSE, sectorNumber + i, &data[i * SectorSize]);
     
     active = TRUE;
-    UpdateLast(sectorNumber);
+    UpdateLastRun(sectorNumber, count, ticks);
     kernel->stats->numDiskReads++;
     kernel->interrupt->Schedule(this, ticks, DiskInt);
 }
 
 void
-Disk::WriteRequest(int sectorNumber, char* data)
+Disk::WriteRequest(int sectorNumber, char* data, int count)
 {
-    int ticks = ComputeLatency(sectorNumber, TRUE);
+    int ticks = RunLatency(sectorNumber, count, TRUE);
 
     ASSERT(!active);
-    ASSERT((sectorNumber >= 0) && (sectorNumber < NumSectors));
+    ASSERT((sectorNumber >= 0) && (count > 0)
+				&& (sectorNumber + count <= NumSectors));
     
-    DEBUG(dbgDisk, "Writing to sector " << sectorNumber);
+    DEBUG(dbgDisk, "Writing to sector " << sectorNumber << ", count " << count);
     Lseek(fileno, SectorSize * sectorNumber + MagicSize, 0);
-    WriteFile(fileno, data, SectorSize);
+    WriteFile(fileno, data, SectorSize * count);
     if (debug->IsEnabled('d'))
-	PrintSector(TRUE, sectorNumber, data);
+	for (int i = 0; i < count; i++)
+	    PrintSector(TRUE, sectorNumber + i, &data[i * SectorSize]);
     
     active = TRUE;
-    UpdateLast(sectorNumber);
+    UpdateLastRun(sectorNumber, count, ticks);
     kernel->stats->numDiskWrites++;
     kernel->interrupt->Schedule(this, ticks, DiskInt);
 }
@@ -249,6 +254,29 @@ Disk::ComputeLatency(int newSector, bool writing)
     return(seek + rotation + RotationTime);
 }
 
+//----------------------------------------------------------------------
+// Disk::RunLatency()
+// 	Return how long a request for "count" consecutive sectors starting
+//	at "firstSector" will take.  The first one costs what ComputeLatency
+//	says.  Each one after it is the next to pass under the head, one
+//	RotationTime later -- except that going on to the next track costs
+//	a seek, and then a wait until its sector 0 comes around again.
+//----------------------------------------------------------------------
+
+int
+Disk::RunLatency(int firstSector, int count, bool writing)
+{
+    int ticks = ComputeLatency(firstSector, writing);
+    int trackTime = SectorsPerTrack * RotationTime;
+
+    for (int sector = firstSector + 1; sector < firstSector + count; sector++) {
+	if ((sector % SectorsPerTrack) == 0)	// on to the next track
+	    ticks += SeekTime + (trackTime - SeekTime % trackTime) % trackTime;
+	ticks += RotationTime;
+    }
+    return ticks;
+}
+
 //----------------------------------------------------------------------
 // Disk::UpdateLast
 //   	Keep track of the most recently requested sector.  So we can know
@@ -266,3 +294,31 @@ Disk::UpdateLast(int newSector)
     lastSector = newSector;
     DEBUG(dbgDisk, "Updating last sector = " << lastSector << " , " << bufferInit);
 }
+
+//----------------------------------------------------------------------
+// Disk::UpdateLastRun
+//   	UpdateLast, for a request of "count" sectors that takes "ticks".
+//	If the request ran onto another track, the track buffer holds
+//	that one, loaded from when the head got to its sector 0.
+//
+//	Also count the tracks the head moves across, to get to the first
+//	sector and from there to the last.
+//----------------------------------------------------------------------
+
+void
+Disk::UpdateLastRun(int firstSector, int count, int ticks)
+{
+    int last = firstSector + count - 1;
+    int tracks = abs(firstSector / SectorsPerTrack - lastSector / SectorsPerTrack)
+		+ (last / SectorsPerTrack - firstSector / SectorsPerTrack);
+
+    if (tracks > 0) {
+	kernel->stats->numDiskSeeks++;
+	kernel->stats->numSeekTracks += tracks;
+    }
+    UpdateLast(firstSector);
+    if ((last / SectorsPerTrack) != (firstSector / SectorsPerTrack))
+	bufferInit = kernel->stats->totalTicks + ticks
+			- ((last % SectorsPerTrack) + 1) * RotationTime;
+    lastSector = last;
+}
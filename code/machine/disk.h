@@ -60,12 +60,13 @@ class Disk : public CallBackObj {
 					// when each request completes.
     ~Disk();				// Deallocate the disk.
     
-    void ReadRequest(int sectorNumber, char* data);
-    					// Read/write an single disk sector.
+    void ReadRequest(int sectorNumber, char* data, int count = 1);
+    					// Read/write "count" consecutive disk
+					// sectors, by default a single one.
 					// These routines send a request to 
     					// the disk and return immediately.
     					// Only one request allowed at a time!
-    void WriteRequest(int sectorNumber, char* data);
+    void WriteRequest(int sectorNumber, char* data, int count = 1);
 
     void CallBack();			// Invoked when disk request 
 					// finishes. In turn calls, callWhenDone.
@@ -85,8 +86,11 @@ class Disk : public CallBackObj {
 					// being loaded
 
     int TimeToSeek(int newSector, int *rotate); // time to get to the new track
+    int RunLatency(int firstSector, int count, bool writing);
+					// ComputeLatency for a run of sectors
     int ModuloDiff(int to, int from);        // # sectors between to and from
     void UpdateLast(int newSector);
+    void UpdateLastRun(int firstSector, int count, int ticks);
 };
 
 #endif // DISK_H
@@ -23,6 +23,8 @@
 #include "copyright.h"
 #include "interrupt.h"
 #include "main.h"
+#include "lockstats.h"
+#include "sectorcache.h"
 
 // String definitions for debugging messages
 
@@ -51,7 +53,9 @@ PendingInterrupt::PendingInterrupt(CallBackObj *callOnInt,
 
 //----------------------------------------------------------------------
 // PendingCompare
-//	Compare to interrupts based on which should occur first.
+//	Compare to interrupts based on which should occur first.  Of two
+//	interrupts due at the same time, the one scheduled first goes
+//	first.
 //----------------------------------------------------------------------
 
 static int
@@ -59,9 +63,163 @@ PendingCompare (PendingInterrupt *x, PendingInterrupt *y)
 {
     if (x->when < y->when) { return -1; }
     else if (x->when > y->when) { return 1; }
+    else if ((int)(x->seq - y->seq) < 0) { return -1; }
+    else if (x->seq != y->seq) { return 1; }
     else { return 0; }
 }
 
+//----------------------------------------------------------------------
+// PendingQueue::PendingQueue
+// 	Initialize an empty queue of pending interrupts.
+//----------------------------------------------------------------------
+
+PendingQueue::PendingQueue()
+{
+    size = PendingQueueSize;
+    heap = new PendingInterrupt *[size];
+    count = 0;
+    nextSeq = 0;
+    freeList = NULL;
+}
+
+//----------------------------------------------------------------------
+// PendingQueue::~PendingQueue
+// 	De-allocate the queue, the interrupts still in it, and the
+//	pooled records.
+//----------------------------------------------------------------------
+
+PendingQueue::~PendingQueue()
+{
+    for (int i = 0; i < count; i++)
+        delete heap[i];
+    while (freeList != NULL) {
+        PendingInterrupt *next = freeList->next;
+        delete freeList;
+        freeList = next;
+    }
+    delete [] heap;
+}
+
+//----------------------------------------------------------------------
+// PendingQueue::Insert
+// 	Add an interrupt, reusing a pooled record if there is one.  The
+//	heap doubles in size when it is full.
+//----------------------------------------------------------------------
+
+void
+PendingQueue::Insert(CallBackObj *callTo, int when, IntType type)
+{
+    PendingInterrupt *toOccur;
+
+    if (freeList != NULL) {
+        toOccur = freeList;
+        freeList = toOccur->next;
+        toOccur->callOnInterrupt = callTo;
+        toOccur->when = when;
+        toOccur->type = type;
+    } else {
+        toOccur = new PendingInterrupt(callTo, when, type);
+    }
+    toOccur->seq = nextSeq++;
+
+    if (count == size) {
+        PendingInterrupt **bigger = new PendingInterrupt *[2 * size];
+        for (int i = 0; i < count; i++)
+            bigger[i] = heap[i];
+        delete [] heap;
+        heap = bigger;
+        size *= 2;
+    }
+    heap[count] = toOccur;
+    SiftUp(count++);
+}
+
+//----------------------------------------------------------------------
+// PendingQueue::RemoveFront
+// 	Take the next interrupt due out of the heap.
+//----------------------------------------------------------------------
+
+PendingInterrupt *
+PendingQueue::RemoveFront()
+{
+    PendingInterrupt *front = heap[0];
+
+    ASSERT(count > 0);
+    heap[0] = heap[--count];
+    if (count > 0)
+        SiftDown(0);
+    return front;
+}
+
+//----------------------------------------------------------------------
+// PendingQueue::Free
+// 	Keep a handled interrupt's record for the next Insert.
+//----------------------------------------------------------------------
+
+void
+PendingQueue::Free(PendingInterrupt *record)
+{
+    record->next = freeList;
+    freeList = record;
+}
+
+//----------------------------------------------------------------------
+// PendingQueue::SiftUp, SiftDown
+// 	Restore the heap order after heap[i] was put in place, by moving
+//	it up towards the root, or down towards the leaves.
+//----------------------------------------------------------------------
+
+void
+PendingQueue::SiftUp(int i)
+{
+    PendingInterrupt *item = heap[i];
+
+    while (i > 0 && PendingCompare(item, heap[(i - 1) / 2]) < 0) {
+        heap[i] = heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap[i] = item;
+}
+
+void
+PendingQueue::SiftDown(int i)
+{
+    PendingInterrupt *item = heap[i];
+    int child;
+
+    while ((child = 2 * i + 1) < count) {
+        if (child + 1 < count && PendingCompare(heap[child + 1], heap[child]) < 0)
+            child++;
+        if (PendingCompare(heap[child], item) >= 0)
+            break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = item;
+}
+
+//----------------------------------------------------------------------
+// PendingQueue::Apply
+// 	Call "func" on every pending interrupt, in the order they will
+//	occur.  Only used to print the queue, so it just sorts a copy.
+//----------------------------------------------------------------------
+
+void
+PendingQueue::Apply(void (*func)(PendingInterrupt *))
+{
+    PendingInterrupt **sorted = new PendingInterrupt *[count];
+
+    for (int i = 0; i < count; i++) {
+        int j = i;
+        for (; j > 0 && PendingCompare(heap[i], sorted[j - 1]) < 0; j--)
+            sorted[j] = sorted[j - 1];
+        sorted[j] = heap[i];
+    }
+    for (int i = 0; i < count; i++)
+        (*func)(sorted[i]);
+    delete [] sorted;
+}
+
 //----------------------------------------------------------------------
 // Interrupt::Interrupt
 // 	Initialize the simulation of hardware device interrupts.
@@ -72,7 +230,7 @@ PendingCompare (PendingInterrupt *x, PendingInterrupt *y)
 Interrupt::Interrupt()
 {
     level = IntOff;
-    pending = new SortedList<PendingInterrupt *>(PendingCompare);
+    pending = new PendingQueue();
     inHandler = FALSE;
     yieldOnReturn = FALSE;
     status = SystemMode;
@@ -85,9 +243,6 @@ Interrupt::Interrupt()
 
 Interrupt::~Interrupt()
 {
-    while (!pending->IsEmpty()) {
-	delete pending->RemoveFront();
-    }
     delete pending;
 }
 
@@ -199,6 +354,10 @@ Interrupt::YieldOnReturn()
 //
 //	If there are no pending interrupts, stop.  There's nothing
 //	more for us to do.
+//
+//	With a tickless alarm ("-tl"), the timer is not re-armed once
+//	nobody is left to time-slice, so after at most one last timer
+//	interrupt the clock jumps straight to the next device interrupt.
 //----------------------------------------------------------------------
 void
 Interrupt::Idle()
@@ -229,8 +388,18 @@ Interrupt::Idle()
 void
 Interrupt::Halt()
 {
+    // the dirty sectors go to disk first, so the statistics count
+    // them (Idle, with interrupts off, never gets here while the
+    // flusher is asleep, since its timer is pending)
+#ifndef FILESYS_STUB
+    if (kernel->sectorCache != NULL && level == IntOn)
+        kernel->sectorCache->Sync();
+#endif
     cout << "Machine halting!\n\n";
     kernel->stats->Print();
+    if (kernel->lockProfiler != NULL)
+        kernel->lockProfiler->Print();
+    kernel->DumpThreadStats();
     delete kernel;	// Never returns.
 }
 
@@ -239,7 +408,7 @@ Interrupt::Halt()
 // 	Arrange for the CPU to be interrupted when simulated time
 //	reaches "now + when".
 //
-//	Implementation: just put it on a sorted list.
+//	Implementation: just put it in the heap of pending interrupts.
 //
 //	NOTE: the Nachos kernel should not call this routine directly.
 //	Instead, it is only called by the hardware device simulators.
@@ -252,12 +421,11 @@ Interrupt::Halt()
 void Interrupt::Schedule(CallBackObj *toCall, int fromNow, IntType type)
 {
     int when = kernel->stats->totalTicks + fromNow;
-    PendingInterrupt *toOccur = new PendingInterrupt(toCall, when, type);
 
     DEBUG(dbgInt, "Scheduling interrupt handler the " << intTypeNames[type] << " at time = " << when);
     ASSERT(fromNow > 0);
 
-    pending->Insert(toOccur);
+    pending->Insert(toCall, when, type);
 }
 
 //----------------------------------------------------------------------
@@ -308,7 +476,7 @@ bool Interrupt::CheckIfDue(bool advanceClock)
     do {
         next = pending->RemoveFront();    // pull interrupt off list
         next->callOnInterrupt->CallBack();// call the interrupt handler
-	    delete next;
+	    pending->Free(next);
     } while (!pending->IsEmpty() && (pending->Front()->when <= stats->totalTicks));
     inHandler = FALSE;
     return TRUE;
@@ -66,6 +66,48 @@ class PendingInterrupt {
     
     int when;			// When the interrupt is supposed to fire
     IntType type;		// for debugging
+    unsigned int seq;		// order in which the interrupts were
+				// scheduled; breaks ties in "when"
+    PendingInterrupt *next;	// next free record, when pooled
+};
+
+// The interrupts scheduled to occur, kept in a binary heap ordered by
+// time, and by order of scheduling among the interrupts due at the same
+// time, so that a simulation always runs the same way.  Schedule and
+// the removal of the front are O(log n).  Records are recycled through
+// a free list instead of going back to the heap allocator.
+
+#define PendingQueueSize 16	// initial room in the heap; it grows
+				// as needed
+
+class PendingQueue {
+  public:
+    PendingQueue();
+    ~PendingQueue();
+
+    void Insert(CallBackObj *callTo, int when, IntType type);
+    PendingInterrupt *Front() { return heap[0]; }
+				// the next interrupt due; the queue
+				// must not be empty
+    PendingInterrupt *RemoveFront();
+				// take out the next interrupt due; give
+				// it back with Free once it is handled
+    void Free(PendingInterrupt *record);
+    bool IsEmpty() { return count == 0; }
+    void Apply(void (*func)(PendingInterrupt *));
+				// call "func" on every interrupt, in
+				// the order they will occur
+
+  private:
+    PendingInterrupt **heap;	// heap[0] is due first; the children
+				// of heap[i] are heap[2i+1], heap[2i+2]
+    int count;			// interrupts in the heap
+    int size;			// room in "heap"
+    unsigned int nextSeq;	// "seq" of the next interrupt scheduled
+    PendingInterrupt *freeList;	// records to reuse
+
+    void SiftUp(int i);
+    void SiftDown(int i);
 };
 
 // The following class defines the data structures for the simulation
@@ -118,9 +160,8 @@ class Interrupt {
 
   private:
     IntStatus level;		// are interrupts enabled or disabled?
-    SortedList<PendingInterrupt *> *pending;		
-    				// the list of interrupts scheduled
-				// to occur in the future
+    PendingQueue *pending;	// the interrupts scheduled to occur
+				// in the future
     bool inHandler;		// TRUE if we are running an interrupt handler
     bool yieldOnReturn; 	// TRUE if we are to context switch
 				// on return from the interrupt handler
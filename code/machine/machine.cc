@@ -78,6 +78,8 @@ Machine::Machine(bool debug)
     pt = NULL;
 #endif
 
+    llBit = FALSE;
+    llAddr = 0;
     singleStep = debug;
     CheckEndian();
 }
@@ -111,6 +113,7 @@ void Machine::RaiseException(ExceptionType which, int badVAddr)
 
     registers[BadVAddrReg] = badVAddr;
     DelayedLoad(0, 0); // finish anything in progress
+    llBit = FALSE;     // like ERET, an exception breaks the LL/SC link
     kernel->interrupt->setStatus(SystemMode);
     ExceptionHandler(which); // interrupts are enabled at this point
     kernel->interrupt->setStatus(UserMode);
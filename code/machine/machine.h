@@ -158,6 +158,10 @@ class Machine {
 	void updateLRUFlag(TranslationEntry* t, int pos, int len);
 	ExceptionType pageTableTranslation(int vpn, int &ppn, TranslationEntry &entry, int virtAddr);
 	void updateTLB(TranslationEntry* tlb, TranslationEntry entry);
+
+    void BreakLink() { llBit = FALSE; }
+				// the running thread is switched out, so
+				// its next SC must fail
 	
   private:
 
@@ -167,6 +171,10 @@ class Machine {
 
     void OneInstruction(Instruction *instr); 	
     				// Run one instruction of a user program.
+
+    bool llBit;			// set by LL, cleared by SC, an exception,
+    				// or a context switch
+    int llAddr;			// the address LL linked
     
 
 
@@ -343,6 +343,22 @@ void Machine::OneInstruction(Instruction *instr)
 		nextLoadValue = value;
 		break;
 
+	case OP_LL:
+		// like LW, but the result is there for the next instruction
+		// already (MIPS II interlocks), and the address is linked
+		tmp = registers[instr->rs] + instr->extra;
+		if (tmp & 0x3)
+		{
+			RaiseException(AddressErrorException, tmp);
+			return;
+		}
+		if (!ReadMem(tmp, 4, &value))
+			return;
+		registers[instr->rt] = value;
+		llBit = TRUE;
+		llAddr = tmp;
+		break;
+
 	case OP_LWL:
 		tmp = registers[instr->rs] + instr->extra;
 
@@ -579,6 +595,26 @@ void Machine::OneInstruction(Instruction *instr)
 			return;
 		break;
 
+	case OP_SC:
+		// store only if nothing may have touched the word since the
+		// LL: no exception and no context switch in between
+		tmp = registers[instr->rs] + instr->extra;
+		if (tmp & 0x3)
+		{
+			RaiseException(AddressErrorException, tmp);
+			return;
+		}
+		if (llBit && llAddr == tmp)
+		{
+			if (!WriteMem(tmp, 4, registers[instr->rt]))
+				return;
+			registers[instr->rt] = 1;
+		}
+		else
+			registers[instr->rt] = 0;
+		llBit = FALSE;
+		break;
+
 	case OP_SWL:
 		tmp = registers[instr->rs] + instr->extra;
 
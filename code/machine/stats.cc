@@ -20,9 +20,16 @@ Statistics::Statistics()
 {
     totalTicks = idleTicks = systemTicks = userTicks = 0;
     numDiskReads = numDiskWrites = 0;
+    numDiskSeeks = numSeekTracks = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
     numPageFaults = numPacketsSent = numPacketsRecvd = 0;
     numTLBMiss = 0;
+    numRealTimeJobs = numDeadlineMisses = numBudgetOverruns = 0;
+    numThreadCacheHits = numThreadCacheMisses = 0;
+    numStackCacheHits = numStackCacheMisses = 0;
+    numTimerInterrupts = numTimerStops = 0;
+    numFutexWaits = numFutexWakes = 0;
+    numCacheHits = numCacheMisses = 0;
 }
 
 //----------------------------------------------------------------------
@@ -38,6 +45,11 @@ Statistics::Print()
 		cout << ", system " << systemTicks << ", user " << userTicks <<"\n";
     cout << "Disk I/O: reads " << numDiskReads;
 		cout << ", writes " << numDiskWrites << "\n";
+    if (numDiskSeeks != 0) {
+	cout << "Disk seeks: " << numDiskSeeks << ", tracks " << numSeekTracks;
+	cout << ", average distance " << (double)numSeekTracks / numDiskSeeks;
+	cout << " tracks\n";
+    }
 		cout << "Console I/O: reads " << numConsoleCharsRead;
     cout << ", writes " << numConsoleCharsWritten << "\n";
 #ifdef USE_TLB
@@ -46,4 +58,25 @@ Statistics::Print()
     if(numAddressTranslation!=0) cout << "Page fault number:" << numPageFaults << ", Page fault rate:" << (double)numPageFaults/numAddressTranslation*100 << "%\n";
     cout << "Network I/O: packets received " << numPacketsRecvd;
 		cout << ", sent " << numPacketsSent << "\n";
+    if (numRealTimeJobs != 0) {
+	cout << "Real-time: jobs " << numRealTimeJobs;
+	cout << ", deadline misses " << numDeadlineMisses;
+	cout << ", budget overruns " << numBudgetOverruns << "\n";
+    }
+    cout << "Thread cache: objects " << numThreadCacheHits << " hits, ";
+	cout << numThreadCacheMisses << " misses; stacks " << numStackCacheHits;
+	cout << " hits, " << numStackCacheMisses << " misses\n";
+    if (numTimerStops != 0) {
+	cout << "Timer: interrupts " << numTimerInterrupts;
+	cout << ", stopped " << numTimerStops << " times\n";
+    }
+    if (numFutexWaits != 0 || numFutexWakes != 0) {
+	cout << "Futex: waits " << numFutexWaits;
+	cout << ", wakes " << numFutexWakes << "\n";
+    }
+    if (numCacheHits != 0 || numCacheMisses != 0) {
+	cout << "Sector cache: hits " << numCacheHits;
+	cout << ", misses " << numCacheMisses << ", hit rate ";
+	cout << (double)numCacheHits / (numCacheHits + numCacheMisses) * 100 << "%\n";
+    }
 }
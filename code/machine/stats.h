@@ -30,6 +30,8 @@ class Statistics {
 
     int numDiskReads;		// number of disk read requests
     int numDiskWrites;		// number of disk write requests
+    int numDiskSeeks;		// disk requests that moved the head
+    int numSeekTracks;		// tracks the head moved across, in all
     int numConsoleCharsRead;	// number of characters read from the keyboard
     int numConsoleCharsWritten; // number of characters written to the display
     int numAddressTranslation;
@@ -37,6 +39,21 @@ class Statistics {
     int numTLBMiss;
     int numPacketsSent;		// number of packets sent over the network
     int numPacketsRecvd;	// number of packets received over the network
+    int numRealTimeJobs;	// number of real-time jobs released
+    int numDeadlineMisses;	// number of real-time jobs that finished late
+    int numBudgetOverruns;	// number of times a real-time thread was
+				// throttled for using up its budget
+    int numThreadCacheHits;	// Thread objects reused from the cache
+    int numThreadCacheMisses;	// Thread objects taken from the heap
+    int numStackCacheHits;	// thread stacks reused from the cache
+    int numStackCacheMisses;	// thread stacks freshly mapped
+    int numTimerInterrupts;	// timer interrupts handled
+    int numTimerStops;		// times the timer was left stopped,
+				// in tickless mode
+    int numFutexWaits;		// FutexWait calls that went to sleep
+    int numFutexWakes;		// threads woken up by FutexWake
+    int numCacheHits;		// sector cache lookups served from memory
+    int numCacheMisses;		// ... and those that were not
 
     Statistics(); 		// initialize everything to zero
 
@@ -10,6 +10,9 @@
 //      In order to introduce some randomness into time-slicing, if "doRandom"
 //      is set, then the interrupt is comes after a random number of ticks.
 //
+//      Like the local APIC timer, the device can also be put in one-shot
+//      mode, where each interrupt has to be asked for with Arm().
+//
 //	Remember -- nothing in here is part of Nachos.  It is just
 //	an emulation for the hardware that Nachos is running on top of.
 //
@@ -40,25 +43,64 @@ Timer::Timer(bool doRandom, CallBackObj *toCall)
     randomize = doRandom;
     callPeriodically = toCall;
     disable = FALSE;
+    periodic = TRUE;
+    armed = FALSE;
     SetInterrupt();
 }
 
 //----------------------------------------------------------------------
 // Timer::CallBack
 //      Routine called when interrupt is generated by the hardware 
-//	timer device.  Schedule the next interrupt, and invoke the
-//	interrupt handler.
+//	timer device.  Invoke the interrupt handler, and schedule the
+//	next interrupt unless the timer is in one-shot mode.
 //----------------------------------------------------------------------
 void 
 Timer::CallBack() 
 {
+    if (!armed || kernel->stats->totalTicks < armedFor)
+        return;		// superseded by an earlier interrupt
+    armed = FALSE;
+
     // invoke the Nachos interrupt handler for this device
     callPeriodically->CallBack();
     
-    SetInterrupt();	// do last, to let software interrupt handler
+    if (periodic)
+        SetInterrupt();	// do last, to let software interrupt handler
     			// decide if it wants to disable future interrupts
 }
 
+//----------------------------------------------------------------------
+// Timer::Arm
+//      Arrange for an interrupt to occur, if none is scheduled yet.
+//	Needed in one-shot mode, harmless in periodic mode.
+//----------------------------------------------------------------------
+
+void
+Timer::Arm()
+{
+    if (!armed)
+        SetInterrupt();
+}
+
+//----------------------------------------------------------------------
+// Timer::Arm
+//      Like the deadline mode of a real timer: make sure an interrupt
+//	occurs within "delay" ticks.  If one is due later than that, it
+//	is left in place, but ignored when it comes.
+//----------------------------------------------------------------------
+
+void
+Timer::Arm(int delay)
+{
+    int when = kernel->stats->totalTicks + delay;
+
+    if (disable || (armed && armedFor <= when))
+        return;
+    kernel->interrupt->Schedule(this, delay, TimerInt);
+    armed = TRUE;
+    armedFor = when;
+}
+
 //----------------------------------------------------------------------
 // Timer::SetInterrupt
 //      Cause a timer interrupt to occur in the future, unless
@@ -77,5 +119,7 @@ Timer::SetInterrupt()
         }
        // schedule the next timer device interrupt
        kernel->interrupt->Schedule(this, delay, TimerInt);
+       armed = TRUE;
+       armedFor = kernel->stats->totalTicks + delay;
     }
 }
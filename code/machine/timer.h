@@ -36,11 +36,23 @@ class Timer : public CallBackObj {
     				// Turn timer device off, so it doesn't
 				// generate any more interrupts.
 
+    void SetOneShot(bool oneShot) { periodic = !oneShot; }
+    				// In one-shot mode the timer does not
+				// re-arm itself after an interrupt
+    void Arm();			// Make sure an interrupt is on its way;
+    				// a no-op if one already is
+    void Arm(int delay);	// Make sure an interrupt comes no later
+				// than "delay" ticks from now
+
   private:
     bool randomize;		// set if we need to use a random timeout delay
     CallBackObj *callPeriodically; // call this every TimerTicks time units 
     bool disable;		// turn off the timer device after next
     				// interrupt.
+    bool periodic;		// re-arm after every interrupt?
+    bool armed;			// an interrupt is scheduled
+    int armedFor;		// when; interrupts that come earlier
+				// were overtaken by a later Arm(delay)
     
     void CallBack();		// called internally when the hardware
 				// timer generates an interrupt
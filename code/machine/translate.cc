@@ -294,7 +294,7 @@ ExceptionType Machine::pageTableTranslation(int vpn, int &pageFrame, Translation
 	bool tmpFindFlag1 = false;
 	for(int i=0;i<NumPhysPages;++i)
 	{
-		if(pt[i].vpn == vpn && pt[i].tID == kernel->currentThread->getTID())
+		if(pt[i].vpn == vpn && pt[i].tID == kernel->currentThread->space->getSpaceID())
 		{
 			tmpFindFlag1 = true;
 			entry = pt[i];
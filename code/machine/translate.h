@@ -30,7 +30,8 @@
 class TranslationEntry {
   public:
     int vpn;  	// The page number in virtual memory.
-	int tID;
+	int tID;	// inverted page table (USE_RPT) only: the
+			// AddrSpace::getSpaceID() of the owning space
     int ppn;  	// The page number in real memory (relative to the
 			//  start of "mainMemory"
     bool valid;         // If this bit is set, the translation is ignored.
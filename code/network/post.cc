@@ -49,7 +49,7 @@ Mail::Mail(PacketHeader pktH, MailHeader mailH, char *msgData)
 
 MailBox::MailBox()
 { 
-    messages = new SynchList<Mail *>(); 
+    messages = new SynchList<Mail *>(MailBoxSize); 
 }
 
 //----------------------------------------------------------------------
@@ -86,22 +86,34 @@ PrintHeader(PacketHeader pktHdr, MailHeader mailHdr)
 // 	Add a message to the mailbox.  If anyone is waiting for message
 //	arrival, wake them up!
 //
+//	If the mailbox is full, the message is thrown away instead: the
+//	postal delivery thread serves every mailbox, so it must not wait
+//	for room in one of them.
+//
 //	We need to reconstruct the Mail message (by concatenating the headers
 //	to the data), to simplify queueing the message on the SynchList.
 //
 //	"pktHdr" -- source, destination machine ID's
 //	"mailHdr" -- source, destination mailbox ID's
 //	"data" -- payload message data
+//
+// Returns:
+//	FALSE if the message was dropped.
 //----------------------------------------------------------------------
 
-void 
+bool 
 MailBox::Put(PacketHeader pktHdr, MailHeader mailHdr, char *data)
 { 
     Mail *mail = new Mail(pktHdr, mailHdr, data); 
 
-    messages->Append(mail);		// put on the end of the list of 
+    if (!messages->TryAppend(mail)) {	// put on the end of the list of 
 					// arrived messages, and wake up 
 					// any waiters
+	DEBUG(dbgNet, "Mailbox " << mailHdr.to << " full, mail dropped");
+	delete mail;
+	return FALSE;
+    }
+    return TRUE;
 }
 
 //----------------------------------------------------------------------
@@ -77,14 +77,20 @@ class Mail {
 // for messages.   Incoming messages are put by the PostOffice into the 
 // appropriate mailbox, and these messages can then be retrieved by
 // threads on this machine.
+//
+// A mailbox holds at most MailBoxSize messages; mail arriving at a
+// full mailbox is dropped, like a packet the network lost.
+
+#define MailBoxSize	16
 
 class MailBox {
   public: 
     MailBox();			// Allocate and initialize mail box
     ~MailBox();			// De-allocate mail box
 
-    void Put(PacketHeader pktHdr, MailHeader mailHdr, char *data);
-   				// Atomically put a message into the mailbox
+    bool Put(PacketHeader pktHdr, MailHeader mailHdr, char *data);
+   				// Atomically put a message into the mailbox;
+				// FALSE if it was full
     void Get(PacketHeader *pktHdr, MailHeader *mailHdr, char *data); 
    				// Atomically get a message out of the 
 				// mailbox (and wait if there is no message 
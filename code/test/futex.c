@@ -0,0 +1,65 @@
+/* futex.c
+ *	Benchmark for the user-level mutex (umutex.c).
+ *
+ *	First one thread takes and releases the lock UNCONTENDED times;
+ *	none of that should enter the kernel.  Then WORKERS threads
+ *	share a counter, each incrementing it ROUNDS times with the lock
+ *	held, yielding the CPU in the middle of the critical section so
+ *	that the others find the lock busy and sleep in FutexWait.
+ *
+ *	Exits with the number of ticks the contended part took, or -1 if
+ *	the counter came out wrong.  Run with "-d s" to see the system
+ *	calls made, and look for the futex counts in the statistics.
+ */
+
+#include "syscall.h"
+#include "umutex.h"
+
+#define UNCONTENDED	1000
+#define WORKERS		4
+#define ROUNDS		20
+
+UMutex mutex = UMUTEX_INITIALIZER;
+int counter;
+
+void
+Worker()
+{
+    int i, c;
+
+    for (i = 0; i < ROUNDS; i++) {
+	UMutexLock(&mutex);
+	c = counter;
+	ThreadYield();
+	counter = c + 1;
+	UMutexUnlock(&mutex);
+    }
+    ThreadExit(0);
+}
+
+int
+main()
+{
+    ThreadId workers[WORKERS];
+    unsigned int start;
+    int i;
+
+    for (i = 0; i < UNCONTENDED; i++) {
+	UMutexLock(&mutex);
+	counter++;
+	UMutexUnlock(&mutex);
+    }
+    if (counter != UNCONTENDED)
+	Exit(-1);
+
+    counter = 0;
+    start = Clock();
+    for (i = 0; i < WORKERS; i++)
+	workers[i] = ThreadFork(Worker);
+    for (i = 0; i < WORKERS; i++)
+	ThreadJoin(workers[i]);
+
+    if (counter != WORKERS * ROUNDS)
+	Exit(-1);
+    Exit(Clock() - start);
+}
@@ -218,6 +218,47 @@ Clock:
 	j       $31
 	.end Clock
 
+	.globl FutexWait
+	.ent   FutexWait
+FutexWait:
+	addiu $2,$0,SC_FutexWait
+	syscall
+	j       $31
+	.end FutexWait
+
+	.globl FutexWake
+	.ent   FutexWake
+FutexWake:
+	addiu $2,$0,SC_FutexWake
+	syscall
+	j       $31
+	.end FutexWake
+
+/* -------------------------------------------------------------
+ * CompareAndSwap
+ *	int CompareAndSwap(int *addr, int old, int new)
+ *	Atomically: if *addr is "old", set it to "new".  Returns what
+ *	*addr held before, so the swap happened if that is "old".
+ *
+ *	Built from the MIPS II load-linked/store-conditional pair: the
+ *	sc fails, and we try again, if another thread ran between the
+ *	ll and the sc.  No system call is made.
+ * -------------------------------------------------------------
+ */
+
+	.globl CompareAndSwap
+	.ent   CompareAndSwap
+CompareAndSwap:
+	.set	mips2
+1:	ll	$2,0($4)
+	bne	$2,$5,2f
+	move	$8,$6
+	sc	$8,0($4)
+	beq	$8,$0,1b
+2:	.set	mips0
+	j       $31
+	.end CompareAndSwap
+
 /* dummy function to keep gcc happy */
         .globl  __main
         .ent    __main
@@ -0,0 +1,62 @@
+/* umutex.c
+ *	User-level mutex, on top of CompareAndSwap and the futex system
+ *	calls.  See umutex.h.
+ */
+
+#include "umutex.h"
+
+void
+UMutexInit(UMutex *m)
+{
+    m->state = 0;
+}
+
+int
+UMutexTryLock(UMutex *m)
+{
+    return CompareAndSwap(&m->state, 0, 1) == 0;
+}
+
+/* Atomically set *addr to "new"; returns what it held before. */
+static int
+Exchange(int *addr, int new)
+{
+    int old;
+
+    do
+	old = *addr;
+    while (CompareAndSwap(addr, old, new) != old);
+    return old;
+}
+
+/* Take the lock.  If it is busy, mark it as having waiters (state 2)
+ * and sleep until it is released.  A thread that sets the state to 2
+ * and finds the lock was free owns it, still marked 2, since other
+ * threads may be asleep on it.
+ */
+void
+UMutexLock(UMutex *m)
+{
+    int c;
+
+    if ((c = CompareAndSwap(&m->state, 0, 1)) == 0)
+	return;			/* fast path: it was free */
+
+    if (c != 2)
+	c = Exchange(&m->state, 2);
+    while (c != 0) {
+	FutexWait(&m->state, 2);
+	c = Exchange(&m->state, 2);
+    }
+}
+
+/* Release the lock, and wake up one waiter if there may be any. */
+void
+UMutexUnlock(UMutex *m)
+{
+    if (CompareAndSwap(&m->state, 1, 0) == 1)
+	return;			/* fast path: nobody waiting */
+
+    m->state = 0;
+    FutexWake(&m->state, 1);
+}
@@ -0,0 +1,30 @@
+/* umutex.h
+ *	A mutual exclusion lock for the threads of a user program.
+ *
+ *	The lock is a word of user memory: 0 if free, 1 if held, 2 if
+ *	held and some thread may be asleep waiting for it.  Acquiring
+ *	a free lock and releasing one nobody waits for are a single
+ *	CompareAndSwap each, without entering the kernel; the FutexWait
+ *	and FutexWake system calls are only used to sleep and to wake a
+ *	sleeper up.
+ */
+
+#ifndef UMUTEX_H
+#define UMUTEX_H
+
+#include "syscall.h"
+
+typedef struct {
+    int state;		/* 0 free, 1 held, 2 held with waiters */
+} UMutex;
+
+#define UMUTEX_INITIALIZER	{ 0 }
+
+int CompareAndSwap(int *addr, int old, int new);
+
+void UMutexInit(UMutex *m);
+void UMutexLock(UMutex *m);
+int UMutexTryLock(UMutex *m);	/* 1 if we got the lock */
+void UMutexUnlock(UMutex *m);
+
+#endif /* UMUTEX_H */
@@ -1,8 +1,17 @@
 // alarm.cc
 //	Routines to use a hardware timer device to provide a
-//	software alarm clock.  For now, we just provide time-slicing.
+//	software alarm clock: time-slicing, and threads sleeping for a
+//	given number of ticks (WaitUntil).  The sleepers are kept in a
+//	hierarchical timing wheel, and woken up from the timer interrupt
+//	that follows their wake-up time.
 //
-//	Not completely implemented.
+//	In tickless mode ("-tl") the timer runs in one-shot mode and is
+//	only kept going while the scheduler has a use for the ticks:
+//	while some thread waits on a ready queue, or the real-time class
+//	has jobs to release.  If only sleepers are left, the timer is
+//	set for the first of them.  Otherwise no timer interrupt is
+//	pending, and an idle machine jumps straight to the next device
+//	interrupt.
 //
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -18,11 +27,29 @@
 //
 //      "doRandom" -- if true, arrange for the hardware interrupts to 
 //		occur at random, instead of fixed, intervals.
+//      "doTickless" -- if true, only ask for timer interrupts when
+//		they are needed.
 //----------------------------------------------------------------------
 
-Alarm::Alarm(bool doRandom)
+Alarm::Alarm(bool doRandom, bool doTickless)
 {
+    tickless = doTickless;
+    wheel = new TimingWheel();
     timer = new Timer(doRandom, this);
+    timer->SetOneShot(tickless);
+}
+
+//----------------------------------------------------------------------
+// Alarm::StartTicking
+//	A thread was just put on a ready queue, so there may be more
+//	than one thread competing for the CPU.  In tickless mode, make
+//	sure the timer is running again.
+//----------------------------------------------------------------------
+
+void Alarm::StartTicking()
+{
+    if (tickless)
+        timer->Arm();
 }
 
 //----------------------------------------------------------------------
@@ -39,21 +66,72 @@ Alarm::Alarm(bool doRandom)
 //	if the interrupted thread called Yield at the point it is 
 //	was interrupted.
 //
-//	For now, just provide time-slicing.  Only need to time slice 
-//      if we're currently running something (in other words, not idle).
+//	For now, just provide time-slicing.  Whether the running thread
+//	has used up its slice is up to the scheduling policy.  In
+//	tickless mode, the next interrupt is only asked for if the
+//	scheduler still needs it.
 //----------------------------------------------------------------------
 
 void Alarm::CallBack() 
 {
     // cout<<"发生一个时钟中断!\n";
-    kernel->currentThread->setRemainTime(kernel->currentThread->getRemainTime() - 1);
     Interrupt *interrupt = kernel->interrupt;
-    MachineStatus status = interrupt->getStatus();
-    
-    if(typeno==1) interrupt->YieldOnReturn();
-    else if ((typeno==2||typeno==3)&&status != IdleMode && kernel->currentThread->getRemainTime()<=0)
-    {
-        DEBUG(dbgThread, kernel->currentThread->getName()<<"的时间片到了，下CPU！");
+    WheelEntry *expired = wheel->Advance(kernel->stats->totalTicks);
+
+    kernel->stats->numTimerInterrupts++;
+    for (; expired != NULL; expired = expired->next)
+        kernel->scheduler->ReadyToRun(expired->thread);
+
+    if (kernel->scheduler->TimerTick() || kernel->scheduler->ShouldPreempt())
         interrupt->YieldOnReturn();
-    }
+
+    if (tickless)
+        Rearm();
+}
+
+//----------------------------------------------------------------------
+// Alarm::Rearm
+//	Tickless mode: ask for another timer interrupt only if the
+//	scheduler needs one, or for the first sleeper due.
+//----------------------------------------------------------------------
+
+void Alarm::Rearm()
+{
+    int now = kernel->stats->totalTicks;
+
+    if (kernel->scheduler->NeedsTick())
+        timer->Arm();
+    else if (wheel->IsEmpty())
+        kernel->stats->numTimerStops++;
+    if (!wheel->IsEmpty())
+        timer->Arm(wheel->NextExpiry() > now ? wheel->NextExpiry() - now : 1);
+}
+
+//----------------------------------------------------------------------
+// Alarm::WaitUntil
+//	Put the current thread to sleep for at least "x" ticks.  It is
+//	woken up, through Scheduler::ReadyToRun, by the first timer
+//	interrupt after its time has come; in periodic mode that can be
+//	up to TimerTicks late.
+//
+//	The wheel entry lives on the sleeping thread's stack, which
+//	stays put until the thread runs again.
+//----------------------------------------------------------------------
+
+void Alarm::WaitUntil(int x)
+{
+    if (x <= 0)
+        return;
+
+    IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+    int now = kernel->stats->totalTicks;
+    WheelEntry entry;
+
+    entry.thread = kernel->currentThread;
+    entry.expires = (now + x + WheelUnit - 1) / WheelUnit;
+    wheel->Insert(&entry, now);
+    if (tickless)
+        timer->Arm(entry.expires * WheelUnit - now);
+    kernel->currentThread->Sleep(FALSE);
+    (void) kernel->interrupt->SetLevel(oldLevel);
 }
@@ -8,8 +8,6 @@
 //	From this, we provide the ability for a thread to be
 //	woken up after a delay; we also provide time-slicing.
 //
-//	NOTE: this abstraction is not completely implemented.
-//
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
 // of liability and disclaimer of warranty provisions.
@@ -21,22 +19,31 @@
 #include "utility.h"
 #include "callback.h"
 #include "timer.h"
+#include "timingwheel.h"
 
 // The following class defines a software alarm clock. 
 class Alarm : public CallBackObj {
   public:
-    Alarm(bool doRandomYield);	// Initialize the timer, and callback 
+    Alarm(bool doRandomYield, bool doTickless);
+				// Initialize the timer, and callback 
 				// to "toCall" every time slice.
-    ~Alarm() { delete timer; }
+    ~Alarm() { delete timer; delete wheel; }
+
+    void StartTicking();	// a thread became ready; restart the
+    				// timer if it was stopped
     
-    void WaitUntil(int x);	// suspend execution until time > now + x
-                                // this method is not yet implemented
+    void WaitUntil(int x);	// suspend execution for at least x ticks
 
   private:
     Timer *timer;		// the hardware timer device
+    bool tickless;		// only keep the timer running when
+    				// the scheduler needs it
+    TimingWheel *wheel;		// threads sleeping in WaitUntil
 
     void CallBack();		// called when the hardware
 				// timer generates an interrupt
+    void Rearm();		// ask for the next interrupt, in
+    				// tickless mode
 };
 
 #endif // ALARM_H
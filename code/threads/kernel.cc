@@ -16,7 +16,14 @@
 #include "string.h"
 #include "synchconsole.h"
 #include "synchdisk.h"
+#include "sectorcache.h"
 #include "post.h"
+#include "threadstats.h"
+#include "lockstats.h"
+#include "threadcache.h"
+#include "threadtable.h"
+#include "futex.h"
+#include <sys/time.h>
 
 #define MAX_PRODUCE_ARRAY_NUM 50
 Semaphore *isFull,*isEmpty;
@@ -37,6 +44,33 @@ Lock *wLock,*rwMutex;
 #define READ_CONTENT_SIZE 100
 int readerCount;
 int readContent[READ_CONTENT_SIZE]={0};
+#define PI_HOG_NUM 3
+Lock *piLockA,*piLockB;
+Semaphore *piDone;
+#define RT_JOB_NUM 5
+Semaphore *rtDone;
+Semaphore *pingSem,*pongSem;
+#define SLEEP_ROUNDS 10
+Semaphore *sleepDone;
+int sleepWakeups,sleepMaxLate;
+long long sleepTotalLate;
+#define RW_OPS 20
+#define RW_HOLD_TICKS (2 * TimerTicks)
+#define RW_THINK_TICKS 50
+#define BARRIER_PHASES 1000
+Barrier *phaseBarrier;
+Semaphore *phaseDone;
+int phaseArrivals;
+#define QUEUE_PRODUCERS 3
+#define QUEUE_ITEMS 600
+#define QUEUE_MAX_BATCH 16
+SynchList<int> *benchQueue;
+Semaphore *queueDone;
+int queueBatch,queueProduced,queueConsumed,queuePeak,queueRemoves;
+RWLock *rwBenchLock;
+Lock *rwBenchMutex;
+Semaphore *rwBenchDone;
+int rwBenchReadPercent,rwBenchReaders,rwBenchWriters,rwBenchUpgradeFails;
 
 //----------------------------------------------------------------------
 // Kernel::Kernel
@@ -50,9 +84,16 @@ Kernel::Kernel(int argc, char **argv)
     debugUserProg = FALSE;
     consoleIn = NULL;  // default is stdin
     consoleOut = NULL; // default is stdout
+    threadStatsFile = NULL;
+    lazyResume = FALSE;
+    tickless = FALSE;
+    lockProfiler = NULL;
+    retiredThreadStats = NULL;
     
+    sectorCache = NULL;
 #ifndef FILESYS_STUB
     formatFlag = FALSE;
+    lruCache = FALSE;
 #endif
     reliability = 1; // network reliability, default is 1.0
     hostName = 0;    // machine id, also UNIX socket name
@@ -82,11 +123,36 @@ Kernel::Kernel(int argc, char **argv)
             ASSERT(i + 1 < argc);
             consoleOut = argv[i + 1];
             i++;
+        }
+        else if (strcmp(argv[i], "-lr") == 0)
+        {
+            lazyResume = TRUE;
+        }
+        else if (strcmp(argv[i], "-tl") == 0)
+        {
+            tickless = TRUE;
+        }
+        else if (strcmp(argv[i], "-lp") == 0)
+        {
+            ASSERT(i + 1 < argc); // next argument is how many to report
+            lockProfiler = new LockProfiler(atoi(argv[i + 1]));
+            i++;
+        }
+        else if (strcmp(argv[i], "-ts") == 0)
+        {
+            ASSERT(i + 1 < argc);
+            threadStatsFile = argv[i + 1];
+            retiredThreadStats = new List<ThreadStats *>;
+            i++;
 #ifndef FILESYS_STUB
         }
         else if (strcmp(argv[i], "-f") == 0)
         {
             formatFlag = TRUE;
+        }
+        else if (strcmp(argv[i], "-lru") == 0)
+        {
+            lruCache = TRUE;
 #endif
         }
         else if (strcmp(argv[i], "-n") == 0)
@@ -106,8 +172,13 @@ Kernel::Kernel(int argc, char **argv)
             cout << "Partial usage: nachos [-rs randomSeed]\n";
             cout << "Partial usage: nachos [-s]\n";
             cout << "Partial usage: nachos [-ci consoleIn] [-co consoleOut]\n";
+            cout << "Partial usage: nachos [-ts threadStatsFile]\n";
+            cout << "Partial usage: nachos [-lr]\n";
+            cout << "Partial usage: nachos [-tl]\n";
+            cout << "Partial usage: nachos [-lp topN]\n";
 #ifndef FILESYS_STUB
             cout << "Partial usage: nachos [-nf]\n";
+            cout << "Partial usage: nachos [-lru]\n";
 #endif
             cout << "Partial usage: nachos [-n #] [-m #]\n";
         }
@@ -123,25 +194,31 @@ Kernel::Kernel(int argc, char **argv)
 
 void Kernel::Initialize()
 {
+    // The statistics come first: every thread, starting with the one
+    // we are running in, takes the time from them for its accounting.
+    stats = new Statistics();       // collect statistics
+    threadCache = new ThreadCache(sizeof(Thread), StackSize * sizeof(int));
+    threadTable = new ThreadTable();
+
     // We didn't explicitly allocate the current thread we are running in.
     // But if it ever tries to give up the CPU, we better have a Thread
     // object to save its state.
-    memset(threadArray,0,sizeof(threadArray));
     currentThread = new Thread("main");
     if(typeno==1) currentThread->setPriority(8);
     currentThread->setStatus(RUNNING);
 
-    stats = new Statistics();       // collect statistics
     interrupt = new Interrupt;      // start up interrupt handling
     scheduler = new Scheduler();    // initialize the ready queue
-    alarm = new Alarm(randomSlice); // start up time slicing
+    alarm = new Alarm(randomSlice, tickless); // start up time slicing
     machine = new Machine(debugUserProg);
+    futexTable = new FutexTable();
     synchConsoleIn = new SynchConsoleInput(consoleIn);    // input from stdin
     synchConsoleOut = new SynchConsoleOutput(consoleOut); // output to stdout
     synchDisk = new SynchDisk();                          //
 #ifdef FILESYS_STUB
     fileSystem = new FileSystem();
 #else
+    sectorCache = new SectorCache(lruCache ? CacheLRU : CacheARC);
     fileSystem = new FileSystem(formatFlag);
 #endif // FILESYS_STUB
     // postOfficeIn = new PostOfficeInput(10);
@@ -161,11 +238,18 @@ Kernel::~Kernel()
     delete interrupt;
     delete scheduler;
     delete alarm;
+    delete threadCache;
+    delete threadTable;
     delete machine;
+    delete futexTable;
     delete synchConsoleIn;
     delete synchConsoleOut;
+#ifndef FILESYS_STUB
+    delete sectorCache;
+#endif
     delete synchDisk;
     delete fileSystem;
+    delete lockProfiler;
     // delete postOfficeIn;
     // delete postOfficeOut;
     Exit(0);
@@ -268,11 +352,59 @@ void Kernel::NetworkTest()
 void Kernel::TS()
 {
     cerr<<"当前全部线程状态：\n";
-    cerr<<"线程ID\t线程名称\t拥有者\t线程状态\t优先级\n";
-    for(int i=0;i<MaxThreadNum;++i)
+    cerr<<"线程ID\t线程名称\t拥有者\t线程状态\t优先级\t运行\t就绪\t阻塞\t挂起\t主动/被动切换\t平均/最长等待\n";
+    for(int i=0;i<threadTable->Size();++i)
+    {
+        if(threadTable->Lookup(i)) threadTable->Lookup(i)->Print();
+    }
+}
+
+//----------------------------------------------------------------------
+// Kernel::RetireThreadStats
+// 	Called when a thread is deleted.  Its accounting record is kept
+//	for the dump at halt time if "-ts" was given, else thrown away.
+//----------------------------------------------------------------------
+
+void Kernel::RetireThreadStats(ThreadStats *record)
+{
+    if (retiredThreadStats != NULL)
+        retiredThreadStats->Append(record);
+    else
+        delete record;
+}
+
+//----------------------------------------------------------------------
+// Kernel::DumpThreadStats
+// 	Write the accounting records of all threads, finished ones
+//	first, to the "-ts" file.  Called by Interrupt::Halt.
+//----------------------------------------------------------------------
+
+void Kernel::DumpThreadStats()
+{
+    if (threadStatsFile == NULL)
+        return;
+
+    int len = strlen(threadStatsFile);
+    bool json = len >= 5 && strcmp(threadStatsFile + len - 5, ".json") == 0;
+    int fd = OpenForWrite(threadStatsFile);
+    bool first = TRUE;
+
+    ThreadStats::WriteHeader(fd, json);
+    ListIterator<ThreadStats *> iter(retiredThreadStats);
+    for (; !iter.IsDone(); iter.Next(), first = FALSE)
+        iter.Item()->Write(fd, json, first);
+    for (int i = 0; i < threadTable->Size(); ++i)
     {
-        if(kernel->threadArray[i]) kernel->threadArray[i]->Print();
+        Thread *t = threadTable->Lookup(i);
+        if (t == NULL)
+            continue;
+        // charge the time spent in the current state so far
+        t->getSchedStats()->Transition(t->getStatus(), t->getStatus(), stats->totalTicks);
+        t->getSchedStats()->Write(fd, json, first);
+        first = FALSE;
     }
+    ThreadStats::WriteTrailer(fd, json);
+    Close(fd);
 }
 
 void static Produce(int which)
@@ -473,10 +605,534 @@ void MyReaderWriter()
     while(!kernel->scheduler->isReadyListEmpty()) kernel->currentThread->Yield();
 }
 
+static void MyPriorityInversion();
+
 void Kernel::SyncTest(int type)
 {
     if(type==0) MyProducerConsumer1();
     else if(type==1) MyProducerConsumer2();
     else if(type==2) MyBarrier();
     else if(type==3) MyReaderWriter();
-}
\ No newline at end of file
+    else if(type==4) MyPriorityInversion();
+}
+
+//----------------------------------------------------------------------
+// Busy
+//	Use up roughly "ticks" of simulated kernel time.  Every time
+//	interrupts are re-enabled the clock advances by SystemTick.
+//----------------------------------------------------------------------
+
+static void Busy(int ticks)
+{
+    for(int i=0;i<ticks;i+=SystemTick)
+    {
+        IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+        (void)kernel->interrupt->SetLevel(oldLevel);
+    }
+}
+
+//----------------------------------------------------------------------
+// MyPriorityInversion
+//	Priority inversion through a chain of two locks: "low" (7) holds
+//	lockA; "mid" (6) takes lockB and waits for lockA; CPU-bound hogs
+//	(4) arrive; then "high" (1) waits for lockB.  Without priority
+//	inheritance "low" never gets the CPU while the hogs run, and
+//	neither does "high"; with it, "high" lends its priority to "mid"
+//	and on to "low", and gets lockB after both critical sections.
+//	Needs "-K 1".
+//----------------------------------------------------------------------
+
+static void PILow(int work)
+{
+    piLockA->Acquire();
+    cerr<<"low获得lockA，时间："<<kernel->stats->totalTicks<<endl;
+    Busy(work);
+    cerr<<"low释放lockA，时间："<<kernel->stats->totalTicks<<endl;
+    piLockA->Release();
+    piDone->V();
+}
+
+static void PIMid(int work)
+{
+    kernel->alarm->WaitUntil(TimerTicks);
+    piLockB->Acquire();
+    cerr<<"mid获得lockB，等待lockA，时间："<<kernel->stats->totalTicks<<endl;
+    piLockA->Acquire();
+    Busy(work);
+    piLockA->Release();
+    piLockB->Release();
+    cerr<<"mid释放lockA和lockB，时间："<<kernel->stats->totalTicks<<endl;
+    piDone->V();
+}
+
+static void PIHog(int work)
+{
+    kernel->alarm->WaitUntil(2 * TimerTicks);
+    Busy(work);
+    cerr<<kernel->currentThread->getName()<<"结束，时间："<<kernel->stats->totalTicks<<endl;
+    piDone->V();
+}
+
+static void PIHigh(int work)
+{
+    kernel->alarm->WaitUntil(3 * TimerTicks);
+    int start = kernel->stats->totalTicks;
+    piLockB->Acquire();
+    cerr<<"high获得lockB，等待了"<<kernel->stats->totalTicks - start<<" ticks"<<endl;
+    Busy(work);
+    piLockB->Release();
+    piDone->V();
+}
+
+static void MyPriorityInversion()
+{
+    static char hogNames[PI_HOG_NUM][20];
+    int oldPriority = kernel->currentThread->getPriority();
+
+    if(typeno!=1)
+    {
+        cerr<<"优先级继承只在优先级调度下生效，请加上 -K 1"<<endl;
+        return;
+    }
+    piLockA = new Lock("lockA");
+    piLockB = new Lock("lockB");
+    piDone = new Semaphore("piDone", 0);
+
+    // create everyone before any of them runs
+    kernel->currentThread->setPriority(0);
+    Thread *low = new Thread("low");
+    low->setPriority(7);
+    low->Fork((VoidFunctionPtr)PILow,(void*)500);
+    Thread *mid = new Thread("mid");
+    mid->setPriority(6);
+    mid->Fork((VoidFunctionPtr)PIMid,(void*)100);
+    for(int i=0;i<PI_HOG_NUM;++i)
+    {
+        sprintf(hogNames[i],"hog%d",i);
+        Thread *hog = new Thread(hogNames[i]);
+        hog->setPriority(4);
+        hog->Fork((VoidFunctionPtr)PIHog,(void*)3000);
+    }
+    Thread *high = new Thread("high");
+    high->setPriority(1);
+    high->Fork((VoidFunctionPtr)PIHigh,(void*)100);
+    kernel->currentThread->setPriority(oldPriority);
+
+    for(int i=0;i<PI_HOG_NUM+3;++i)
+        piDone->P();
+    delete piLockA;
+    delete piLockB;
+    delete piDone;
+}
+
+static void ControlLoop(int work)
+{
+    Thread *t = kernel->currentThread;
+    for(int i=0;i<RT_JOB_NUM;++i)
+    {
+        cerr<<t->getName()<<" job "<<i<<" released at "<<t->getRelease()<<", deadline "<<t->getDeadline()<<endl;
+        Busy(work);
+        cerr<<t->getName()<<" job "<<i<<" done at "<<kernel->stats->totalTicks<<endl;
+        t->WaitForNextPeriod();
+    }
+    rtDone->V();
+}
+
+static void Background(int which)
+{
+    for(int i=0;i<20;++i)
+    {
+        Busy(200);
+        cerr<<"background"<<which<<" step "<<i<<" at "<<kernel->stats->totalTicks<<endl;
+    }
+}
+
+//----------------------------------------------------------------------
+// Kernel::RealTimeTest
+//	Two periodic control loops run under EDF next to a CPU-bound
+//	normal thread; a third loop is rejected by admission control.
+//----------------------------------------------------------------------
+
+void Kernel::RealTimeTest()
+{
+    Thread *fast = new Thread("rt-fast");
+    Thread *slow = new Thread("rt-slow");
+    Thread *greedy = new Thread("rt-greedy");
+    Thread *bg = new Thread("background");
+    bool admitted;
+
+    rtDone = new Semaphore("rtDone", 0);
+    admitted = fast->SetRealTime(1000, 300, 1000);
+    ASSERT(admitted);
+    admitted = slow->SetRealTime(1500, 400, 1200);
+    ASSERT(admitted);
+    if(!greedy->SetRealTime(1000, 600, 1000))
+        cerr<<"rt-greedy rejected by admission control"<<endl;
+
+    bg->Fork((VoidFunctionPtr)Background,(void*)0);
+    fast->Fork((VoidFunctionPtr)ControlLoop,(void*)200);
+    slow->Fork((VoidFunctionPtr)ControlLoop,(void*)300);
+    greedy->Fork((VoidFunctionPtr)Background,(void*)1);
+    rtDone->P();
+    rtDone->P();
+    while(!kernel->scheduler->isReadyListEmpty()) kernel->currentThread->Yield();
+}
+
+static void Pong(int rounds)
+{
+    for(int i=0;i<rounds;++i)
+    {
+        pingSem->P();
+        pongSem->V();
+    }
+}
+
+//----------------------------------------------------------------------
+// Kernel::SwitchBenchmark
+//	Two threads hand the CPU back and forth "rounds" times through
+//	a pair of semaphores, so that nearly all the work is Semaphore::P,
+//	Semaphore::V and the context switch itself.  Prints the number of
+//	switches per second of host time, to compare SWITCH backends and
+//	to keep an eye on the cost of the switch path.
+//----------------------------------------------------------------------
+
+void Kernel::SwitchBenchmark(int rounds)
+{
+    Thread *pong = new Thread("pong");
+    ThreadStats *mine = currentThread->getSchedStats();
+    struct timeval start, end;
+
+    pingSem = new Semaphore("ping", 0);
+    pongSem = new Semaphore("pong", 0);
+    pong->Fork((VoidFunctionPtr)Pong,(void*)rounds);
+
+    int switchesBefore = mine->voluntarySwitches + mine->involuntarySwitches;
+    int ticksBefore = stats->totalTicks;
+    gettimeofday(&start, NULL);
+    for(int i=0;i<rounds;++i)
+    {
+        pingSem->V();
+        pongSem->P();
+    }
+    gettimeofday(&end, NULL);
+
+    // every switch away from main is followed by one back to it
+    int switches = 2 * (mine->voluntarySwitches + mine->involuntarySwitches - switchesBefore);
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+#ifdef x86_64
+    const char *backend = "x86-64";
+#else
+    const char *backend = "x86";
+#endif
+    cerr<<"SWITCH backend: "<<backend<<endl;
+    cerr<<rounds<<" rounds, "<<switches<<" context switches in "<<seconds<<" s host time, "
+        <<(stats->totalTicks - ticksBefore)<<" ticks"<<endl;
+    if(seconds > 0)
+        cerr<<"switches per host second: "<<(long)(switches / seconds)<<endl;
+
+    delete pingSem;
+    delete pongSem;
+}
+
+static void Sleeper(int period)
+{
+    for(int i=0;i<SLEEP_ROUNDS;++i)
+    {
+        int due = kernel->stats->totalTicks + period;
+        kernel->alarm->WaitUntil(period);
+        int late = kernel->stats->totalTicks - due;
+        ASSERT(late >= 0);
+        sleepWakeups++;
+        sleepTotalLate += late;
+        if(late > sleepMaxLate) sleepMaxLate = late;
+    }
+    sleepDone->V();
+}
+
+//----------------------------------------------------------------------
+// Kernel::SleepBenchmark
+//	"threads" periodic sleepers, with periods of 1 to 16 timer
+//	intervals, each sleep SLEEP_ROUNDS times through
+//	Alarm::WaitUntil while main waits for them.  Prints how late
+//	the wake-ups were, and what the run cost in simulated and host
+//	time; compare with and without "-tl".
+//----------------------------------------------------------------------
+
+void Kernel::SleepBenchmark(int threads)
+{
+    struct timeval start, end;
+    int ticksBefore = stats->totalTicks;
+    int idleBefore = stats->idleTicks;
+    int interruptsBefore = stats->numTimerInterrupts;
+
+    sleepDone = new Semaphore("sleepDone", 0);
+    sleepWakeups = sleepMaxLate = 0;
+    sleepTotalLate = 0;
+    gettimeofday(&start, NULL);
+    for(int i=0;i<threads;++i)
+    {
+        Thread *t = new Thread("sleeper");
+        t->Fork((VoidFunctionPtr)Sleeper,(void*)(TimerTicks * (1 + i % 16)));
+    }
+    for(int i=0;i<threads;++i)
+        sleepDone->P();
+    gettimeofday(&end, NULL);
+
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+    cerr<<threads<<" sleepers, "<<sleepWakeups<<" wake-ups, lateness avg "
+        <<(sleepWakeups ? sleepTotalLate / sleepWakeups : 0)<<" max "<<sleepMaxLate<<" ticks"<<endl;
+    cerr<<(stats->totalTicks - ticksBefore)<<" ticks ("<<(stats->idleTicks - idleBefore)<<" idle), "
+        <<(stats->numTimerInterrupts - interruptsBefore)<<" timer interrupts, "
+        <<seconds<<" s host time"<<endl;
+
+    delete sleepDone;
+}
+
+//----------------------------------------------------------------------
+// RWReader, RWWriter
+//	One read or write of the shared structure in the reader-writer
+//	lock benchmark.  Holding the lock costs RW_HOLD_TICKS of waiting
+//	(think of a lookup that has to go to disk), which is what lets
+//	readers overlap.  A writer first looks as a reader, then upgrades
+//	(falling back to AcquireWrite if another reader is upgrading),
+//	writes, and downgrades to look at the result.  Under a plain Lock
+//	(rwBenchLock == NULL) the same steps are all done holding it.
+//----------------------------------------------------------------------
+
+static void RWReader()
+{
+    if(rwBenchLock) rwBenchLock->AcquireRead();
+    else rwBenchMutex->Acquire();
+    rwBenchReaders++;
+    ASSERT(rwBenchWriters == 0);
+    kernel->alarm->WaitUntil(RW_HOLD_TICKS);
+    rwBenchReaders--;
+    if(rwBenchLock) rwBenchLock->ReleaseRead();
+    else rwBenchMutex->Release();
+}
+
+static void RWWriter()
+{
+    if(rwBenchLock) rwBenchLock->AcquireRead();
+    else rwBenchMutex->Acquire();
+    rwBenchReaders++;
+    kernel->alarm->WaitUntil(RW_HOLD_TICKS);
+    rwBenchReaders--;
+    if(rwBenchLock && !rwBenchLock->Upgrade())
+    {
+        rwBenchUpgradeFails++;
+        rwBenchLock->ReleaseRead();
+        rwBenchLock->AcquireWrite();
+    }
+    rwBenchWriters++;
+    ASSERT(rwBenchWriters == 1 && rwBenchReaders == 0);
+    kernel->alarm->WaitUntil(RW_HOLD_TICKS);
+    rwBenchWriters--;
+    if(rwBenchLock)
+    {
+        rwBenchLock->Downgrade();
+        rwBenchLock->ReleaseRead();
+    }
+    else rwBenchMutex->Release();
+}
+
+static void RWWorker(int which)
+{
+    unsigned int seed = 12345 + which * 7919;
+    for(int i=0;i<RW_OPS;++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        if((int)((seed >> 16) % 100) < rwBenchReadPercent) RWReader();
+        else RWWriter();
+        Busy(RW_THINK_TICKS);
+    }
+    rwBenchDone->V();
+}
+
+//----------------------------------------------------------------------
+// Kernel::RWLockBenchmark
+//	"threads" workers each do RW_OPS reads or writes of a shared
+//	structure, at 50%, 90% and 99% reads, once with a Lock and once
+//	with an RWLock under each policy.  Prints the simulated time each
+//	run took and the resulting throughput, in operations per 1000
+//	ticks, along with the host time.
+//----------------------------------------------------------------------
+
+void Kernel::RWLockBenchmark(int threads)
+{
+    static int readPercents[] = { 50, 90, 99 };
+    static const char *kindNames[] = { "Lock", "RWLock reader-pref",
+                                       "RWLock writer-pref", "RWLock fair" };
+    static RWPolicy policies[] = { RWReaderPreference, RWWriterPreference, RWFair };
+
+    rwBenchMutex = new Lock("rwBench");
+    rwBenchDone = new Semaphore("rwBenchDone", 0);
+    cerr<<threads<<" threads, "<<RW_OPS<<" operations each, lock held "<<RW_HOLD_TICKS<<" ticks"<<endl;
+    for(int r=0;r<3;++r)
+    {
+        for(int kind=0;kind<4;++kind)
+        {
+            struct timeval start, end;
+            int ticksBefore = stats->totalTicks;
+
+            rwBenchLock = kind ? new RWLock("rwBench", policies[kind - 1]) : NULL;
+            rwBenchReadPercent = readPercents[r];
+            rwBenchReaders = rwBenchWriters = rwBenchUpgradeFails = 0;
+            gettimeofday(&start, NULL);
+            for(int i=0;i<threads;++i)
+            {
+                Thread *t = new Thread("rw-worker");
+                t->Fork((VoidFunctionPtr)RWWorker,(void*)i);
+            }
+            for(int i=0;i<threads;++i)
+                rwBenchDone->P();
+            gettimeofday(&end, NULL);
+
+            int ticks = stats->totalTicks - ticksBefore;
+            double seconds = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+            cerr<<readPercents[r]<<"% reads, "<<kindNames[kind]<<": "<<ticks<<" ticks, "
+                <<(ticks ? threads * RW_OPS * 1000.0 / ticks : 0)<<" ops per 1000 ticks, "
+                <<seconds<<" s host time";
+            if(rwBenchUpgradeFails)
+                cerr<<", "<<rwBenchUpgradeFails<<" upgrades lost";
+            cerr<<endl;
+            delete rwBenchLock;
+        }
+    }
+    rwBenchLock = NULL;
+    delete rwBenchMutex;
+    delete rwBenchDone;
+}
+
+static void PhaseWorker(int threads)
+{
+    for(int phase=0;phase<BARRIER_PHASES;++phase)
+    {
+        phaseArrivals++;
+        phaseBarrier->Wait();
+        // everyone has arrived for this phase, and no one can be more
+        // than one phase ahead of us
+        ASSERT(phaseArrivals >= (phase + 1) * threads);
+        ASSERT(phaseArrivals <= (phase + 2) * threads);
+    }
+    phaseDone->V();
+}
+
+static void QueueProducer(int which)
+{
+    int items[QUEUE_MAX_BATCH];
+
+    for(int i=0;i<QUEUE_ITEMS;i+=queueBatch)
+    {
+        int n = min(queueBatch, QUEUE_ITEMS - i);
+        for(int j=0;j<n;++j)
+            items[j] = which * QUEUE_ITEMS + i + j;
+        benchQueue->AppendN(items, n);
+        queueProduced += n;
+        queuePeak = max(queuePeak, queueProduced - queueConsumed);
+    }
+    queueDone->V();
+}
+
+static void QueueConsumer(int total)
+{
+    int items[QUEUE_MAX_BATCH];
+
+    while(queueConsumed < total)
+    {
+        queueConsumed += benchQueue->RemoveUpTo(items, queueBatch);
+        queueRemoves++;
+        kernel->currentThread->Yield(); // a slow consumer
+    }
+    queueDone->V();
+}
+
+//----------------------------------------------------------------------
+// Kernel::QueueBenchmark
+//	QUEUE_PRODUCERS fast producers and one slow consumer pass
+//	QUEUE_ITEMS items each through a SynchList, unbounded and then
+//	holding at most "capacity" items, moving 1, 4 and 16 items per
+//	call.  Prints the time per item, how many items were queued at
+//	most, and how many lock round-trips the consumer made.
+//----------------------------------------------------------------------
+
+void Kernel::QueueBenchmark(int capacity)
+{
+    static int batches[] = { 1, 4, QUEUE_MAX_BATCH };
+    int total = QUEUE_PRODUCERS * QUEUE_ITEMS;
+
+    queueDone = new Semaphore("queueDone", 0);
+    cerr<<QUEUE_PRODUCERS<<" producers, "<<QUEUE_ITEMS<<" items each"<<endl;
+    for(int bounded=0;bounded<2;++bounded)
+    {
+        for(int b=0;b<3;++b)
+        {
+            int ticksBefore = stats->totalTicks;
+
+            benchQueue = new SynchList<int>(bounded ? capacity : 0);
+            queueBatch = batches[b];
+            queueProduced = queueConsumed = queuePeak = queueRemoves = 0;
+            for(int i=0;i<QUEUE_PRODUCERS;++i)
+            {
+                Thread *t = new Thread("producer");
+                t->Fork((VoidFunctionPtr)QueueProducer,(void*)i);
+            }
+            Thread *t = new Thread("consumer");
+            t->Fork((VoidFunctionPtr)QueueConsumer,(void*)total);
+            for(int i=0;i<=QUEUE_PRODUCERS;++i)
+                queueDone->P();
+            ASSERT(queueConsumed == total);
+
+            int ticks = stats->totalTicks - ticksBefore;
+            if(bounded) cerr<<"capacity "<<capacity;
+            else cerr<<"unbounded";
+            cerr<<", batch "<<queueBatch<<": "<<ticks<<" ticks, "
+                <<(double)ticks / total<<" ticks per item, at most "
+                <<queuePeak<<" queued, "<<queueRemoves<<" removes"<<endl;
+            delete benchQueue;
+        }
+    }
+    delete queueDone;
+}
+
+//----------------------------------------------------------------------
+// Kernel::BarrierBenchmark
+//	"threads" workers go through BARRIER_PHASES phases of a Barrier,
+//	flat and as combining trees of a few fan-ins.  Prints the host
+//	and simulated time each shape took.
+//----------------------------------------------------------------------
+
+void Kernel::BarrierBenchmark(int threads)
+{
+    static int fanIns[] = { 0, 2, 4, 8 };
+
+    phaseDone = new Semaphore("phaseDone", 0);
+    cerr<<threads<<" threads, "<<BARRIER_PHASES<<" phases"<<endl;
+    for(int f=0;f<4;++f)
+    {
+        struct timeval start, end;
+        int ticksBefore = stats->totalTicks;
+
+        phaseBarrier = new Barrier("phase", threads, fanIns[f]);
+        phaseArrivals = 0;
+        gettimeofday(&start, NULL);
+        for(int i=0;i<threads;++i)
+        {
+            Thread *t = new Thread("phase-worker");
+            t->Fork((VoidFunctionPtr)PhaseWorker,(void*)threads);
+        }
+        for(int i=0;i<threads;++i)
+            phaseDone->P();
+        gettimeofday(&end, NULL);
+
+        double seconds = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+        if(fanIns[f]) cerr<<"tree, fan-in "<<fanIns[f];
+        else cerr<<"flat";
+        cerr<<": "<<(stats->totalTicks - ticksBefore)<<" ticks, "<<seconds<<" s host time";
+        if(seconds > 0)
+            cerr<<", "<<(long)(BARRIER_PHASES / seconds)<<" phases per host second";
+        cerr<<endl;
+        delete phaseBarrier;
+    }
+    delete phaseDone;
+}
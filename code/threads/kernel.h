@@ -24,6 +24,11 @@ class PostOfficeOutput;
 class SynchConsoleInput;
 class SynchConsoleOutput;
 class SynchDisk;
+class SectorCache;
+class ThreadCache;
+class ThreadTable;
+class LockProfiler;
+class FutexTable;
 
 class Kernel {
   public:
@@ -43,8 +48,25 @@ class Kernel {
 
     void SyncTest(int type);
 
+    void RealTimeTest();	// periodic threads under the EDF class
+
+    void SwitchBenchmark(int rounds);
+				// context switches per host second
+    void SleepBenchmark(int threads);
+				// many periodic Alarm::WaitUntil sleepers
+    void RWLockBenchmark(int threads);
+				// RWLock against Lock, by read/write ratio
+    void BarrierBenchmark(int threads);
+				// flat and combining-tree Barrier phases
+    void QueueBenchmark(int capacity);
+				// bounded and batched SynchList traffic
+
     void TS();
 
+    void RetireThreadStats(ThreadStats *record);
+				// a thread is being deleted
+    void DumpThreadStats();	// write out the "-ts" file, if any
+
 // These are public for notational convenience; really, 
 // they're global variables used everywhere.
 
@@ -53,16 +75,25 @@ class Kernel {
     Interrupt *interrupt;	// interrupt status
     Statistics *stats;		// performance metrics
     Alarm *alarm;		// the software alarm clock    
+    ThreadCache *threadCache;	// recycled Thread objects and stacks
     Machine *machine;           // the simulated CPU
     SynchConsoleInput *synchConsoleIn;
     SynchConsoleOutput *synchConsoleOut;
     SynchDisk *synchDisk;
+    SectorCache *sectorCache;	// write-back cache over synchDisk, NULL
+				// with the stub file system
     FileSystem *fileSystem;     
     PostOfficeInput *postOfficeIn;
     PostOfficeOutput *postOfficeOut;
-    Thread* threadArray[MaxThreadNum];//线程数组
+    ThreadTable *threadTable;	// all threads, by thread ID
+    FutexTable *futexTable;	// user threads asleep in FutexWait
 
     int hostName;               // machine identifier
+    bool lazyResume;		// page a resumed thread in on first
+				// touch, instead of all at once
+    bool tickless;		// only run the timer when it is needed
+    LockProfiler *lockProfiler;	// contention accounting, NULL unless
+				// "-lp"
 
   private:
     bool randomSlice;		// enable pseudo-random time slicing
@@ -70,8 +101,12 @@ class Kernel {
     double reliability;         // likelihood messages are dropped
     char *consoleIn;            // file to read console input from
     char *consoleOut;           // file to send console output to
+    char *threadStatsFile;	// where to dump per-thread accounting
+    List<ThreadStats *> *retiredThreadStats;
+				// records of the threads already deleted
 #ifndef FILESYS_STUB
     bool formatFlag;          // format the disk if this is true
+    bool lruCache;		// "-lru": plain LRU sector cache, not ARC
 #endif
 };
 
@@ -0,0 +1,110 @@
+// lockstats.cc
+//	Routines to account for contention on synchronization objects.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "lockstats.h"
+
+//----------------------------------------------------------------------
+// LockStats::LockStats
+// 	Start accounting for the objects called "debugName".
+//----------------------------------------------------------------------
+
+LockStats::LockStats(char *debugName, char *kind)
+{
+    strncpy(name, debugName, StatsNameLen - 1);
+    name[StatsNameLen - 1] = '\0';
+    this->kind = kind;
+    acquisitions = contentions = 0;
+    waitTicks = 0;
+    maxWait = maxHold = 0;
+}
+
+LockProfiler::LockProfiler(int topN)
+{
+    this->topN = topN;
+    records = new List<LockStats *>;
+}
+
+LockProfiler::~LockProfiler()
+{
+    while (!records->IsEmpty())
+        delete records->RemoveFront();
+    delete records;
+}
+
+//----------------------------------------------------------------------
+// LockProfiler::Lookup
+// 	Return the record for the objects named "debugName" of the given
+//	kind, making a new one the first time.  Only called when an
+//	object is created, so a walk down the list will do.
+//----------------------------------------------------------------------
+
+LockStats *LockProfiler::Lookup(char *debugName, char *kind)
+{
+    char copy[StatsNameLen];
+
+    if (debugName == NULL)
+        debugName = "(no name)";
+    strncpy(copy, debugName, StatsNameLen - 1);
+    copy[StatsNameLen - 1] = '\0';
+
+    ListIterator<LockStats *> iter(records);
+    for (; !iter.IsDone(); iter.Next())
+    {
+        LockStats *record = iter.Item();
+        if (strcmp(record->kind, kind) == 0 && strcmp(record->name, copy) == 0)
+            return record;
+    }
+    LockStats *record = new LockStats(copy, kind);
+    records->Append(record);
+    return record;
+}
+
+//----------------------------------------------------------------------
+// LockProfiler::Print
+// 	Print the "topN" records with the most ticks spent waiting, and
+//	among those that were never waited for, the most used.
+//----------------------------------------------------------------------
+
+static int
+MoreContended(LockStats *x, LockStats *y)
+{
+    if (x->waitTicks != y->waitTicks)
+        return x->waitTicks > y->waitTicks ? -1 : 1;
+    if (x->contentions != y->contentions)
+        return x->contentions > y->contentions ? -1 : 1;
+    return y->acquisitions - x->acquisitions;
+}
+
+void LockProfiler::Print()
+{
+    SortedList<LockStats *> sorted(MoreContended);
+    int shown = 0;
+
+    ListIterator<LockStats *> iter(records);
+    for (; !iter.IsDone(); iter.Next())
+    {
+        if (iter.Item()->acquisitions > 0)
+            sorted.Insert(iter.Item());
+    }
+
+    cout << "Lock contention (top " << topN << " of " << sorted.NumInList()
+         << ", by ticks waited):\n";
+    cout << "name\tkind\tacquired\tcontended\twait ticks\tmax wait\tmax hold\n";
+    ListIterator<LockStats *> top(&sorted);
+    for (; !top.IsDone() && shown < topN; top.Next(), shown++)
+    {
+        LockStats *r = top.Item();
+        cout << r->name << "\t" << r->kind << "\t" << r->acquisitions << "\t"
+             << r->contentions << "\t" << r->waitTicks << "\t" << r->maxWait
+             << "\t";
+        if (strcmp(r->kind, "lock") == 0)
+            cout << r->maxHold << "\n";
+        else
+            cout << "-\n";
+    }
+}
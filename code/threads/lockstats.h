@@ -0,0 +1,66 @@
+// lockstats.h
+//	Contention accounting for semaphores, locks and condition
+//	variables.
+//
+//	With "-lp <n>", every synchronization object gets a LockStats
+//	record when it is created, shared by all objects with the same
+//	debug name, so the many instances of one kernel lock add up
+//	together.  Semaphore::P, Lock::Acquire/Release and
+//	Condition::Wait update the record: how many times it was taken,
+//	how many of those had to wait, how long the waits were, and (for
+//	locks) the longest time it was held.  When the machine halts, the
+//	n records with the most waiting are printed.
+//
+//	Without "-lp", the objects have no record and the only cost is
+//	a test for NULL.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef LOCKSTATS_H
+#define LOCKSTATS_H
+
+#include "copyright.h"
+#include "list.h"
+#include "threadstats.h"
+
+class LockStats {
+  public:
+    LockStats(char *debugName, char *kind);
+
+    void Acquired(bool contended, int waited) {
+	acquisitions++;
+	if (!contended) return;
+	contentions++;
+	waitTicks += waited;
+	if (waited > maxWait) maxWait = waited; }
+				// taken, after "waited" ticks
+    void Released(int held) { if (held > maxHold) maxHold = held; }
+				// given back after "held" ticks
+
+    char name[StatsNameLen];	// a copy, like ThreadStats::name
+    char *kind;			// "semaphore", "lock" or "condition"
+    int acquisitions;		// P, Acquire or Wait calls
+    int contentions;		// ... of which had to wait
+    long long waitTicks;	// total ticks spent waiting
+    int maxWait;		// longest single contended wait
+    int maxHold;		// longest a lock was held
+};
+
+class LockProfiler {
+  public:
+    LockProfiler(int topN);	// report the "topN" worst at halt
+    ~LockProfiler();
+
+    LockStats *Lookup(char *debugName, char *kind);
+				// the record for objects of that name
+				// and kind; created if needed
+    void Print();		// the report
+
+  private:
+    int topN;
+    List<LockStats *> *records;
+};
+
+#endif // LOCKSTATS_H
@@ -5,9 +5,12 @@
 // Usage: nachos -d <debugflags> -rs <random seed #>
 //              -s -x <nachos file> -ci <consoleIn> -co <consoleOut>
 //              -f -cp <unix file> <nachos file>
-//              -p <nachos file> -r <nachos file> -l -D
+//              -p <nachos file> -r <nachos file> -l -D -lru
+//              -mkdir <nachos directory>
 //              -n <network reliability> -m <machine id>
-//              -z -K -C -N
+//              -z -K -C -N -RT -cs <rounds> -sl <threads> -rw <threads>
+//              -br <threads> -bq <capacity>
+//              -ts <stats file> -lr -tl -lp <n>
 //
 //    -d causes certain debugging messages to be printed (see debug.h)
 //    -rs causes Yield to occur at random (but repeatable) spots
@@ -21,14 +24,31 @@
 //    -K run a simple self test of kernel threads and synchronization
 //    -C run an interactive console test
 //    -N run a two-machine network test (see Kernel::NetworkTest)
+//    -RT run periodic threads under the real-time EDF class
+//    -cs measure context switches per host second (ping-pong between
+//        two threads through Semaphore::P/V)
+//    -sl run many periodic sleepers on Alarm::WaitUntil
+//    -rw compare RWLock with Lock at several read/write ratios
+//    -br time phases of flat and combining-tree Barriers
+//    -bq pass items through unbounded and bounded SynchLists, one or
+//        several at a time
+//    -ts at halt, write per-thread scheduling accounting to a file
+//        (JSON if its name ends in .json, CSV otherwise)
+//    -lr page a resumed thread back in on first touch, not all at once
+//    -tl tickless: only run the timer while threads compete for the CPU
+//    -lp at halt, print the <n> most contended semaphores, locks and
+//        condition variables
 //
 //    Filesystem-related flags:
 //    -f forces the Nachos disk to be formatted
 //    -cp copies a file from UNIX to Nachos
 //    -p prints a Nachos file to stdout
-//    -r removes a Nachos file from the file system
-//    -l lists the contents of the Nachos directory
+//    -r removes a Nachos file (or empty directory) from the file system
+//    -mkdir creates a Nachos directory; Nachos file names can be
+//       paths, like "a/b/c"
+//    -l lists the contents of the Nachos directory tree
 //    -D prints the contents of the entire file system
+//    -lru replace cached disk sectors LRU instead of ARC
 //
 //  Note: the file system flags are not used if the stub filesystem
 //        is being used
@@ -197,11 +217,18 @@ int main(int argc, char **argv)
     bool consoleTestFlag = false;
     bool networkTestFlag = false;
     int syncTestFlag = -1;
+    bool realTimeTestFlag = false;
+    int switchRounds = 0;
+    int sleepThreads = 0;
+    int rwThreads = 0;
+    int barrierThreads = 0;
+    int queueCapacity = 0;
 #ifndef FILESYS_STUB
     char *copyUnixFileName = NULL;   // UNIX file to be copied into Nachos
     char *copyNachosFileName = NULL; // name of copied file in Nachos
     char *printFileName = NULL;
     char *removeFileName = NULL;
+    char *mkdirName = NULL;          // Nachos directory to be created
     bool dirListFlag = false;
     bool dumpFlag = false;
 #endif //FILESYS_STUB
@@ -248,6 +275,40 @@ int main(int argc, char **argv)
         {
             networkTestFlag = TRUE;
         }
+        else if (strcmp(argv[i], "-RT") == 0)
+        {
+            realTimeTestFlag = TRUE;
+        }
+        else if (strcmp(argv[i], "-cs") == 0)
+        {
+            ASSERT(i + 1 < argc); // next argument is the number of rounds
+            switchRounds = atoi(argv[i + 1]);
+            i++;
+        }
+        else if (strcmp(argv[i], "-sl") == 0)
+        {
+            ASSERT(i + 1 < argc); // next argument is the number of threads
+            sleepThreads = atoi(argv[i + 1]);
+            i++;
+        }
+        else if (strcmp(argv[i], "-rw") == 0)
+        {
+            ASSERT(i + 1 < argc); // next argument is the number of threads
+            rwThreads = atoi(argv[i + 1]);
+            i++;
+        }
+        else if (strcmp(argv[i], "-br") == 0)
+        {
+            ASSERT(i + 1 < argc); // next argument is the number of threads
+            barrierThreads = atoi(argv[i + 1]);
+            i++;
+        }
+        else if (strcmp(argv[i], "-bq") == 0)
+        {
+            ASSERT(i + 1 < argc); // next argument is the list capacity
+            queueCapacity = atoi(argv[i + 1]);
+            i++;
+        }
 #ifndef FILESYS_STUB
         else if (strcmp(argv[i], "-cp") == 0)
         {
@@ -268,6 +329,12 @@ int main(int argc, char **argv)
             removeFileName = argv[i + 1];
             i++;
         }
+        else if (strcmp(argv[i], "-mkdir") == 0)
+        {
+            ASSERT(i + 1 < argc);
+            mkdirName = argv[i + 1];
+            i++;
+        }
         else if (strcmp(argv[i], "-l") == 0)
         {
             dirListFlag = true;
@@ -281,10 +348,11 @@ int main(int argc, char **argv)
         {
             cout << "Partial usage: nachos [-z -d debugFlags]\n";
             cout << "Partial usage: nachos [-x programName]\n";
-            cout << "Partial usage: nachos [-K] [-C] [-N]\n";
+            cout << "Partial usage: nachos [-K] [-C] [-N] [-RT] [-cs rounds] [-sl threads] [-rw threads] [-br threads] [-bq capacity]\n";
 #ifndef FILESYS_STUB
             cout << "Partial usage: nachos [-cp UnixFile NachosFile]\n";
             cout << "Partial usage: nachos [-p fileName] [-r fileName]\n";
+            cout << "Partial usage: nachos [-mkdir directoryName]\n";
             cout << "Partial usage: nachos [-l] [-D]\n";
 #endif //FILESYS_STUB
         }
@@ -329,12 +397,41 @@ int main(int argc, char **argv)
     {
         kernel->SyncTest(syncTestFlag);
     }
+    if (realTimeTestFlag)
+    {
+        kernel->RealTimeTest();
+    }
+    if (switchRounds > 0)
+    {
+        kernel->SwitchBenchmark(switchRounds);
+    }
+    if (sleepThreads > 0)
+    {
+        kernel->SleepBenchmark(sleepThreads);
+    }
+    if (rwThreads > 0)
+    {
+        kernel->RWLockBenchmark(rwThreads);
+    }
+    if (barrierThreads > 0)
+    {
+        kernel->BarrierBenchmark(barrierThreads);
+    }
+    if (queueCapacity > 0)
+    {
+        kernel->QueueBenchmark(queueCapacity);
+    }
 
 #ifndef FILESYS_STUB
     if (removeFileName != NULL)
     {
         kernel->fileSystem->Remove(removeFileName);
     }
+    if (mkdirName != NULL)
+    {
+        if (!kernel->fileSystem->Mkdir(mkdirName))
+            cout << "Could not create directory " << mkdirName << "\n";
+    }
     if (copyUnixFileName != NULL && copyNachosFileName != NULL)
     {
         Copy(copyUnixFileName, copyNachosFileName);
@@ -0,0 +1,475 @@
+// schedpolicy.cc
+//	Routines implementing the scheduling policies: FIFO, round robin,
+//	preemptive priority and multi-level feedback queue, plus the
+//	earliest-deadline-first real-time class.
+//
+// 	These routines assume that interrupts are already disabled.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "debug.h"
+#include "schedpolicy.h"
+#include "main.h"
+
+//----------------------------------------------------------------------
+// SchedulingPolicy::Create
+// 	Allocate the scheduling policy selected on the command line.
+//	Called once, when the scheduler is created at boot.
+//
+//	"type" is the value of typeno (see main.cc).
+//----------------------------------------------------------------------
+
+SchedulingPolicy *
+SchedulingPolicy::Create(int type)
+{
+    switch (type) {
+      case 1:
+	return new PriorityPolicy();
+      case 2:
+	return new RRPolicy();
+      case 3:
+	return new MLFQPolicy();
+      default:
+	return new FIFOPolicy();
+    }
+}
+
+//----------------------------------------------------------------------
+// FIFOPolicy
+//----------------------------------------------------------------------
+
+void FIFOPolicy::Enqueue(Thread *thread)
+{
+    readyList->Append(thread);
+}
+
+void FIFOPolicy::EnqueueAll(IntrusiveList<Thread> *threads)
+{
+    readyList->Splice(threads);
+}
+
+Thread *FIFOPolicy::Dequeue()
+{
+    if (readyList->IsEmpty())
+        return NULL;
+    if(debug->IsEnabled('t')) cerr<<"从就绪队列中选出线程："<<readyList->Front()->getName()<<endl;
+    return readyList->RemoveFront();
+}
+
+Thread *FIFOPolicy::Front()
+{
+    if (readyList->IsEmpty())
+        return NULL;
+    return readyList->Front();
+}
+
+void FIFOPolicy::Print()
+{
+    readyList->Apply(ThreadPrint);
+}
+
+//----------------------------------------------------------------------
+// RRPolicy
+//	FIFO order, but every thread gets a fresh time slice when it is
+//	put on the ready list, and is preempted when the slice runs out.
+//----------------------------------------------------------------------
+
+void RRPolicy::Enqueue(Thread *thread)
+{
+    thread->setRemainTime(timeSlice);
+    readyList->Append(thread);
+}
+
+static void
+FreshTimeSlice(Thread *thread)
+{
+    thread->setRemainTime(timeSlice);
+}
+
+void RRPolicy::EnqueueAll(IntrusiveList<Thread> *threads)
+{
+    threads->Apply(FreshTimeSlice);
+    readyList->Splice(threads);
+}
+
+Thread *RRPolicy::Dequeue()
+{
+    if (readyList->IsEmpty())
+        return NULL;
+    if(debug->IsEnabled('t'))
+    {
+        Print();
+        cerr<<"从就绪队列中选出线程："<<readyList->Front()->getName()<<";剩余时间片:"<<readyList->Front()->getRemainTime()<<endl;
+    }
+    return readyList->RemoveFront();
+}
+
+bool RRPolicy::TimerTick(Thread *current, MachineStatus status)
+{
+    current->setRemainTime(current->getRemainTime() - 1);
+    if (status != IdleMode && current->getRemainTime() <= 0)
+    {
+        DEBUG(dbgThread, current->getName()<<"的时间片到了，下CPU！");
+        return TRUE;
+    }
+    return FALSE;
+}
+
+//----------------------------------------------------------------------
+// PriorityPolicy
+//	The ready list is kept sorted by priority; the running thread is
+//	checked for preemption on every timer interrupt, and whenever a
+//	new thread becomes ready.
+//----------------------------------------------------------------------
+
+static int
+PriorityCompare(Thread *t1, Thread *t2)
+{
+    if(t1->getPriority()<t2->getPriority()) return -1;
+    else if(t1->getPriority()>t2->getPriority()) return 1;
+    return 0;
+}
+
+PriorityPolicy::PriorityPolicy()
+{
+    sortedReadyList = new IntrusiveList<Thread>(&Thread::queueLink);
+}
+
+void PriorityPolicy::Enqueue(Thread *thread)
+{
+    sortedReadyList->Insert(thread, PriorityCompare);
+}
+
+Thread *PriorityPolicy::Dequeue()
+{
+    if (sortedReadyList->IsEmpty())
+        return NULL;
+    if(debug->IsEnabled('t')) cerr<<"从就绪队列中选出线程："<<sortedReadyList->Front()->getName()<<"；优先级："<<sortedReadyList->Front()->getPriority()<<endl;
+    return sortedReadyList->RemoveFront();
+}
+
+Thread *PriorityPolicy::Front()
+{
+    if (sortedReadyList->IsEmpty())
+        return NULL;
+    return sortedReadyList->Front();
+}
+
+void PriorityPolicy::Print()
+{
+    sortedReadyList->Apply(ThreadPrint);
+}
+
+bool PriorityPolicy::ShouldPreempt(Thread *current)
+{
+    Thread *front = Front();
+    return front != NULL && front->getPriority() < current->getPriority();
+}
+
+// A ready thread's priority was raised or lowered by a Lock: move it
+// to its new place.
+void PriorityPolicy::Requeue(Thread *thread)
+{
+    sortedReadyList->Remove(thread);
+    Enqueue(thread);
+}
+
+//----------------------------------------------------------------------
+// MLFQPolicy
+//----------------------------------------------------------------------
+
+MLFQPolicy::MLFQPolicy()
+{
+    for(int i=0;i<QueueNum;++i) threadArrQueue[i]=new IntrusiveList<Thread>(&Thread::queueLink);
+}
+
+MLFQPolicy::~MLFQPolicy()
+{
+    for(int i=0;i<QueueNum;++i) delete threadArrQueue[i];
+}
+
+void MLFQPolicy::Enqueue(Thread *thread)
+{
+    if(thread->getPriority()!=QueueNum-1)
+    {
+        thread->setPriority(thread->getPriority()+1);
+    }
+    thread->setRemainTime(threadArrTimeSlice[thread->getPriority()]);
+    threadArrQueue[thread->getPriority()]->Append(thread);
+    cerr<<thread->getName()<<"进入第"<<thread->getPriority()<<"级队列,时间片为:"<<thread->getRemainTime()<<endl;
+}
+
+Thread *MLFQPolicy::Dequeue()
+{
+    for(int i=0;i<QueueNum;++i)
+    {
+        if(!threadArrQueue[i]->IsEmpty())
+        {
+            if(debug->IsEnabled('t')) cerr<<"从就绪队列中选出线程："<<threadArrQueue[i]->Front()->getName()<<";所在队列:"<<i<<";剩余时间片:"<<threadArrQueue[i]->Front()->getRemainTime()<<endl;
+            return threadArrQueue[i]->RemoveFront();
+        }
+    }
+    return NULL;
+}
+
+Thread *MLFQPolicy::Front()
+{
+    for(int i=0;i<QueueNum;++i)
+    {
+        if(!threadArrQueue[i]->IsEmpty()) return threadArrQueue[i]->Front();
+    }
+    return NULL;
+}
+
+bool MLFQPolicy::IsEmpty()
+{
+    for(int i=0;i<QueueNum;++i)
+    {
+        if(!threadArrQueue[i]->IsEmpty()) return false;
+    }
+    return true;
+}
+
+void MLFQPolicy::Print()
+{
+    for(int i=0;i<QueueNum;++i)
+    {
+        cerr<<"第"<<i<<"级队列:\n";
+        threadArrQueue[i]->Apply(ThreadPrint);
+    }
+}
+
+bool MLFQPolicy::TimerTick(Thread *current, MachineStatus status)
+{
+    current->setRemainTime(current->getRemainTime() - 1);
+    if (status != IdleMode && current->getRemainTime() <= 0)
+    {
+        DEBUG(dbgThread, current->getName()<<"的时间片到了，下CPU！");
+        return TRUE;
+    }
+    return FALSE;
+}
+
+//----------------------------------------------------------------------
+// EDFPolicy
+//	Real-time jobs ordered by absolute deadline.  Threads that have
+//	used up their budget, or that have finished their job, sit on
+//	the release list until their next period starts.
+//----------------------------------------------------------------------
+
+static int
+DeadlineCompare(Thread *t1, Thread *t2)
+{
+    if(t1->getDeadline()<t2->getDeadline()) return -1;
+    else if(t1->getDeadline()>t2->getDeadline()) return 1;
+    return 0;
+}
+
+static int
+NextRelease(Thread *t)
+{
+    return t->getRelease() + t->getPeriod();
+}
+
+static int
+ReleaseCompare(Thread *t1, Thread *t2)
+{
+    if(NextRelease(t1)<NextRelease(t2)) return -1;
+    else if(NextRelease(t1)>NextRelease(t2)) return 1;
+    return 0;
+}
+
+EDFPolicy::EDFPolicy()
+{
+    readyList = new IntrusiveList<Thread>(&Thread::queueLink);
+    releaseList = new IntrusiveList<Thread>(&Thread::queueLink);
+    utilization = 0.0;
+}
+
+EDFPolicy::~EDFPolicy()
+{
+    delete readyList;
+    delete releaseList;
+}
+
+//----------------------------------------------------------------------
+// EDFPolicy::Admit
+//	Admit a new periodic thread if the total density, the sum of
+//	budget/min(period, deadline), stays at or below 1.  That is the
+//	exact EDF bound when deadline == period, and a sufficient one
+//	when the deadline is shorter.
+//----------------------------------------------------------------------
+
+bool EDFPolicy::Admit(int period, int budget, int deadline)
+{
+    double density = (double)budget / min(period, deadline);
+
+    if (utilization + density > 1.0 + 1e-9) {
+        DEBUG(dbgThread, "Real-time admission rejected, utilization " << utilization << " + " << density);
+        return FALSE;
+    }
+    utilization += density;
+    return TRUE;
+}
+
+void EDFPolicy::Retire(Thread *thread)
+{
+    utilization -= (double)thread->getBudget() /
+            min(thread->getPeriod(), thread->getRelativeDeadline());
+}
+
+//----------------------------------------------------------------------
+// EDFPolicy::Charge
+//	Charge the simulated time "thread" has run since it was last
+//	charged (or dispatched) against the budget of its current job.
+//----------------------------------------------------------------------
+
+void EDFPolicy::Charge(Thread *thread)
+{
+    int now = kernel->stats->totalTicks;
+
+    thread->setBudgetRemain(thread->getBudgetRemain() - (now - thread->getLastCharged()));
+    thread->setLastCharged(now);
+}
+
+//----------------------------------------------------------------------
+// EDFPolicy::Enqueue
+//	Put a real-time thread on the ready list.  If it has no budget
+//	left, throttle it until its next release instead.
+//----------------------------------------------------------------------
+
+void EDFPolicy::Enqueue(Thread *thread)
+{
+    int now = kernel->stats->totalTicks;
+
+    if (thread == kernel->currentThread)
+        Charge(thread);
+    if (thread->getBudgetRemain() <= 0) {
+        kernel->stats->numBudgetOverruns++;
+        if (NextRelease(thread) > now) {
+            DEBUG(dbgThread, "Throttling real-time thread " << thread->getName() << " until " << NextRelease(thread));
+            thread->setStatus(BLOCKED);
+            releaseList->Insert(thread, ReleaseCompare);
+            return;
+        }
+        if (now > thread->getDeadline())
+            kernel->stats->numDeadlineMisses++;
+        thread->ReleaseJob(NextRelease(thread));
+    }
+    readyList->Insert(thread, DeadlineCompare);
+}
+
+Thread *EDFPolicy::Dequeue()
+{
+    if (readyList->IsEmpty())
+        return NULL;
+    if(debug->IsEnabled('t')) cerr<<"从实时就绪队列中选出线程："<<readyList->Front()->getName()<<"；截止时间："<<readyList->Front()->getDeadline()<<endl;
+    return readyList->RemoveFront();
+}
+
+Thread *EDFPolicy::Front()
+{
+    if (readyList->IsEmpty())
+        return NULL;
+    return readyList->Front();
+}
+
+void EDFPolicy::Print()
+{
+    cerr<<"实时队列:\n";
+    readyList->Apply(ThreadPrint);
+}
+
+//----------------------------------------------------------------------
+// EDFPolicy::ShouldPreempt
+//	Real-time threads preempt any normal thread, and each other in
+//	deadline order.
+//----------------------------------------------------------------------
+
+bool EDFPolicy::ShouldPreempt(Thread *current)
+{
+    Thread *front = Front();
+
+    if (front == NULL)
+        return FALSE;
+    return !current->IsRealTime() || front->getDeadline() < current->getDeadline();
+}
+
+//----------------------------------------------------------------------
+// EDFPolicy::JobDone
+//	Called when "thread" finishes its current job.  Record a
+//	deadline miss if it finished late.  If the next period has
+//	already started, begin the next job right away; otherwise put
+//	the thread on the release list and tell the caller to sleep.
+//----------------------------------------------------------------------
+
+bool EDFPolicy::JobDone(Thread *thread)
+{
+    int now = kernel->stats->totalTicks;
+
+    Charge(thread);
+    if (now > thread->getDeadline())
+        kernel->stats->numDeadlineMisses++;
+    if (NextRelease(thread) <= now) {
+        thread->ReleaseJob(NextRelease(thread));
+        return FALSE;
+    }
+    releaseList->Insert(thread, ReleaseCompare);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// EDFPolicy::ReleaseDue
+//	Start the next job of every thread whose release time has come.
+//	A throttled thread still had an unfinished job, which missed
+//	its deadline if that has passed.
+//----------------------------------------------------------------------
+
+void EDFPolicy::ReleaseDue()
+{
+    int now = kernel->stats->totalTicks;
+
+    while (!releaseList->IsEmpty() && NextRelease(releaseList->Front()) <= now) {
+        Thread *thread = releaseList->RemoveFront();
+
+        if (thread->getBudgetRemain() <= 0 && now > thread->getDeadline())
+            kernel->stats->numDeadlineMisses++;
+        thread->ReleaseJob(NextRelease(thread));
+        kernel->scheduler->ReadyToRun(thread);
+    }
+}
+
+//----------------------------------------------------------------------
+// EDFPolicy::TimerTick
+//	Release due jobs and enforce the budget of the running thread.
+//	A thread over budget is only switched out if something else can
+//	run; otherwise it keeps the idle CPU until its next job.
+//----------------------------------------------------------------------
+
+bool EDFPolicy::TimerTick(Thread *current, MachineStatus status)
+{
+    ReleaseDue();
+    if (status == IdleMode)
+        return FALSE;
+    if (current->IsRealTime()) {
+        Charge(current);
+        if (current->getBudgetRemain() <= 0 && !kernel->scheduler->isReadyListEmpty())
+            return TRUE;
+    }
+    return ShouldPreempt(current);
+}
+
+//----------------------------------------------------------------------
+// EDFPolicy::NeedsTick
+//	Releases, and the budget of a running real-time thread, are
+//	only looked at on timer interrupts, so the timer has to keep
+//	going as long as any of them is pending.
+//----------------------------------------------------------------------
+
+bool EDFPolicy::NeedsTick(Thread *current)
+{
+    return !readyList->IsEmpty() || !releaseList->IsEmpty() || current->IsRealTime();
+}
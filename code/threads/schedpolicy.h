@@ -0,0 +1,187 @@
+// schedpolicy.h
+//	Data structures for the pluggable scheduling policies.
+//
+//	The scheduler (scheduler.h) only knows how to dispatch threads;
+//	the decision of which ready thread runs next, and when the
+//	running thread should give up the CPU, is delegated to a
+//	SchedulingPolicy.  Exactly one policy is created at boot, based
+//	on the "-K" argument (typeno), and only that policy's ready
+//	queues are allocated.
+//
+//	To add a new policy, derive from SchedulingPolicy and add a case
+//	to SchedulingPolicy::Create.  Nothing else in the dispatcher
+//	needs to change.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef SCHEDPOLICY_H
+#define SCHEDPOLICY_H
+
+#include "copyright.h"
+#include "ilist.h"
+#include "thread.h"
+#include "interrupt.h"
+
+const int timeSlice = 3;
+#define QueueNum 5
+const int threadArrTimeSlice[QueueNum]={3,4,5,6,7};
+
+// The following class defines the interface every scheduling policy
+// has to provide.  All routines are called with interrupts disabled.
+
+class SchedulingPolicy {
+  public:
+    virtual ~SchedulingPolicy() {}
+
+    static SchedulingPolicy *Create(int type);
+				// allocate the policy selected by "-K"
+
+    virtual void Enqueue(Thread *thread) = 0;
+				// put a READY thread on the ready queue(s)
+    virtual void EnqueueAll(IntrusiveList<Thread> *threads) {
+	while (!threads->IsEmpty()) Enqueue(threads->RemoveFront()); }
+				// the same for a whole list of READY
+				// threads, which is left empty
+    virtual Thread *Dequeue() = 0;
+				// remove the next thread to run, or NULL
+    virtual Thread *Front() = 0;
+				// next thread to run, without removing it
+    virtual bool IsEmpty() = 0;	// no thread is ready to run?
+    virtual void Print() = 0;	// print the ready queue(s)
+
+    virtual bool TimerTick(Thread *current, MachineStatus status) = 0;
+				// called from Alarm::CallBack on every
+				// timer interrupt; return TRUE if the
+				// running thread should be preempted
+    virtual bool ShouldPreempt(Thread *current) { return FALSE; }
+				// called after a thread is made ready;
+				// return TRUE if "current" should yield
+				// to the front of the ready queue now
+    virtual bool NeedsTick(Thread *current) { return !IsEmpty(); }
+				// does the policy have any use for the
+				// next timer interrupt?  Asked in
+				// tickless mode only
+    virtual void Requeue(Thread *thread) {}
+				// the priority of "thread", which is
+				// READY, has changed
+};
+
+// Straight FIFO, no preemption (typeno 0).
+
+class FIFOPolicy : public SchedulingPolicy {
+  public:
+    FIFOPolicy() { readyList = new IntrusiveList<Thread>(&Thread::queueLink); }
+    ~FIFOPolicy() { delete readyList; }
+
+    void Enqueue(Thread *thread);
+    void EnqueueAll(IntrusiveList<Thread> *threads);
+    Thread *Dequeue();
+    Thread *Front();
+    bool IsEmpty() { return readyList->IsEmpty(); }
+    void Print();
+    bool TimerTick(Thread *current, MachineStatus status) { return FALSE; }
+
+  protected:
+    IntrusiveList<Thread> *readyList;	// threads ready to run, in arrival order
+};
+
+// Round robin with a fixed time slice (typeno 2).
+
+class RRPolicy : public FIFOPolicy {
+  public:
+    void Enqueue(Thread *thread);
+    void EnqueueAll(IntrusiveList<Thread> *threads);
+    Thread *Dequeue();
+    bool TimerTick(Thread *current, MachineStatus status);
+};
+
+// Preemptive priority; a smaller number means a higher priority
+// (typeno 1).
+
+class PriorityPolicy : public SchedulingPolicy {
+  public:
+    PriorityPolicy();
+    ~PriorityPolicy() { delete sortedReadyList; }
+
+    void Enqueue(Thread *thread);
+    Thread *Dequeue();
+    Thread *Front();
+    bool IsEmpty() { return sortedReadyList->IsEmpty(); }
+    void Print();
+    bool TimerTick(Thread *current, MachineStatus status) { return TRUE; }
+    bool ShouldPreempt(Thread *current);
+    void Requeue(Thread *thread);
+
+  private:
+    IntrusiveList<Thread> *sortedReadyList;	// ready threads, by priority
+};
+
+// Multi-level feedback queue (typeno 3).  A thread drops one level
+// every time it is put back on the ready queue, and gets the (longer)
+// time slice of its new level.
+
+class MLFQPolicy : public SchedulingPolicy {
+  public:
+    MLFQPolicy();
+    ~MLFQPolicy();
+
+    void Enqueue(Thread *thread);
+    Thread *Dequeue();
+    Thread *Front();
+    bool IsEmpty();
+    void Print();
+    bool TimerTick(Thread *current, MachineStatus status);
+
+  private:
+    IntrusiveList<Thread> *threadArrQueue[QueueNum];	// one ready queue per level
+};
+
+// Earliest-deadline-first real-time class.  It is not selected with
+// "-K": the scheduler creates it when the first real-time thread is
+// admitted, and always runs its threads ahead of the normal policy.
+//
+// Each real-time thread has a period, a budget and a relative
+// deadline, all in simulated ticks.  A thread that uses up its budget
+// is throttled until its next release; a thread that finishes its job
+// waits on the release list.  Releases and budget checks happen on the
+// timer interrupt, so they have the resolution of the timer.
+
+class EDFPolicy : public SchedulingPolicy {
+  public:
+    EDFPolicy();
+    ~EDFPolicy();
+
+    bool Admit(int period, int budget, int deadline);
+				// utilization-based admission control
+    void Retire(Thread *thread);// give back the thread's utilization
+
+    void Enqueue(Thread *thread);
+    Thread *Dequeue();
+    Thread *Front();
+    bool IsEmpty() { return readyList->IsEmpty(); }
+    void Print();
+    bool TimerTick(Thread *current, MachineStatus status);
+    bool ShouldPreempt(Thread *current);
+    bool NeedsTick(Thread *current);
+
+    bool JobDone(Thread *thread);
+				// the current job of "thread" completed;
+				// return TRUE if it has to wait for
+				// its next release
+    void Charge(Thread *thread);// charge the CPU time used since the
+				// thread was last charged to its budget
+
+  private:
+    IntrusiveList<Thread> *readyList;	// ready jobs, by absolute deadline
+    IntrusiveList<Thread> *releaseList;	// waiting or throttled threads,
+					// by next release time
+    double utilization;		// sum of budget/min(period, deadline)
+				// over all admitted threads
+
+    void ReleaseDue();		// move threads whose release time
+				// has come to the ready list
+};
+
+#endif // SCHEDPOLICY_H
@@ -11,8 +11,9 @@
 //	end up calling FindNextToRun(), and that would put us in an
 //	infinite loop.
 //
-// 	Very simple implementation -- no priorities, straight FIFO.
-//	Might need to be improved in later assignments.
+// 	Which ready thread runs next is decided by the SchedulingPolicy
+//	selected at boot (see schedpolicy.cc); the scheduler itself only
+//	does the dispatching.
 //
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation
@@ -22,31 +23,22 @@
 #include "debug.h"
 #include "scheduler.h"
 #include "main.h"
+#include "threadstats.h"
 
 //----------------------------------------------------------------------
 // Scheduler::Scheduler
 // 	Initialize the list of ready but not running threads.
-//	Initially, no ready threads.
+//	Initially, no ready threads.  Only the ready queue(s) of the
+//	policy selected by "-K" are allocated.
 //----------------------------------------------------------------------
 
-int cmp(Thread* t1,Thread* t2)
-{
-    if(t1->getPriority()<t2->getPriority()) return -1;
-    else if(t1->getPriority()>t2->getPriority()) return 1;
-    return 0;
-}
-
 Scheduler::Scheduler()
 {
-    //FIFO
-    readyList = new List<Thread *>;
-    //抢占式优先级
-    sortedReadyList = new SortedList<Thread *>(cmp);
-    //多级反馈队列
-    for(int i=0;i<QueueNum;++i) threadArrQueue[i]=new List<Thread*>;
+    policy = SchedulingPolicy::Create(typeno);
+    rtPolicy = NULL;
 
-    suspendList = new List<Thread*>;
-    blockList = new List<Thread*>;
+    suspendList = new IntrusiveList<Thread>(&Thread::blockLink);
+    blockList = new IntrusiveList<Thread>(&Thread::blockLink);
 
     toBeDestroyed = NULL;
 }
@@ -58,9 +50,9 @@ Scheduler::Scheduler()
 
 Scheduler::~Scheduler()
 {
-    delete readyList;
-    delete sortedReadyList;
-    for(int i=0;i<QueueNum;++i) delete threadArrQueue[i];
+    delete policy;
+    if (rtPolicy != NULL)
+        delete rtPolicy;
     delete suspendList;
     delete blockList;
 }
@@ -80,28 +72,49 @@ void Scheduler::ReadyToRun(Thread *thread)
 
     if(blockList->IsInList(thread)) blockList->Remove(thread);
     thread->setStatus(READY);//将该线程状态设置为就绪态
-    if(typeno==1) sortedReadyList->Insert(thread);//抢占式优先级
-    else if(typeno==0||typeno==2)
+    if (thread->IsRealTime())
+        rtPolicy->Enqueue(thread);
+    else
+        policy->Enqueue(thread);
+    kernel->alarm->StartTicking();
+}
+
+//----------------------------------------------------------------------
+// Scheduler::ReadyToRunAll
+// 	Make every thread on "threads" ready, in order, as if by
+//	ReadyToRun.  The policy gets them as one list, so FIFO and round
+//	robin can splice it onto the ready queue in one go.  Real-time
+//	threads each need their own place in the EDF queue, so if that
+//	class is active, they are simply made ready one at a time.
+//----------------------------------------------------------------------
+
+void Scheduler::ReadyToRunAll(IntrusiveList<Thread> *threads)
+{
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+
+    if (threads->IsEmpty())
+        return;
+    if (rtPolicy != NULL)
     {
-        if(typeno==2) thread->setRemainTime(timeSlice);
-        readyList->Append(thread);//FIFO
+        while (!threads->IsEmpty())
+            ReadyToRun(threads->RemoveFront());
+        return;
     }
-    else if(typeno==3)
+    for (Thread *thread = threads->Front(); thread != NULL; thread = threads->Next(thread))
     {
-        if(thread->getPriority()!=QueueNum-1)
-        {
-            thread->setPriority(thread->getPriority()+1);
-        }
-        thread->setRemainTime(threadArrTimeSlice[thread->getPriority()]);
-        threadArrQueue[thread->getPriority()]->Append(thread);
-        cerr<<thread->getName()<<"进入第"<<thread->getPriority()<<"级队列,时间片为:"<<thread->getRemainTime()<<endl;
+        DEBUG(dbgThread, "Putting thread on ready list: " << thread->getName());
+        if (blockList->IsInList(thread)) blockList->Remove(thread);
+        thread->setStatus(READY);
     }
+    policy->EnqueueAll(threads);
+    kernel->alarm->StartTicking();
 }
 
 //----------------------------------------------------------------------
 // Scheduler::FindNextToRun
 // 	Return the next thread to be scheduled onto the CPU.
 //	If there are no ready threads, return NULL.
+//	Real-time threads always go ahead of the normal policy.
 // Side effect:
 //	Thread is removed from the ready list.
 //----------------------------------------------------------------------
@@ -111,50 +124,9 @@ Thread* Scheduler::FindNextToRun()
     ASSERT(kernel->interrupt->getLevel() == IntOff);
 
     if(debug->IsEnabled('t')) kernel->TS();
-    if(typeno==0)
-    {
-        if (!readyList->IsEmpty())
-        {
-            // Print();
-            if(debug->IsEnabled('t')) cerr<<"从就绪队列中选出线程："<<readyList->Front()->getName()<<endl;
-            return readyList->RemoveFront();
-        }
-    }
-    else if(typeno==1)
-    {
-        if (!sortedReadyList->IsEmpty())
-        {
-            // Print();
-            if(debug->IsEnabled('t')) cerr<<"从就绪队列中选出线程："<<sortedReadyList->Front()->getName()<<"；优先级："<<sortedReadyList->Front()->getPriority()<<endl;
-            return sortedReadyList->RemoveFront();
-        }
-    }
-    else if(typeno==2)
-    {
-        if (!readyList->IsEmpty())
-        {
-            if(debug->IsEnabled('t'))
-            {
-                Print();
-                cerr<<"从就绪队列中选出线程："<<readyList->Front()->getName()<<";剩余时间片:"<<readyList->Front()->getRemainTime()<<endl;
-            }
-            return readyList->RemoveFront();
-        }
-    }
-    else if(typeno==3)
-    {
-        // Print();
-        for(int i=0;i<QueueNum;++i)
-        {
-            if(!threadArrQueue[i]->IsEmpty())
-            {
-                if(debug->IsEnabled('t')) cerr<<"从就绪队列中选出线程："<<threadArrQueue[i]->Front()->getName()<<";所在队列:"<<i<<";剩余时间片:"<<threadArrQueue[i]->Front()->getRemainTime()<<endl;
-                return threadArrQueue[i]->RemoveFront();
-            }
-        }
-    }
-    
-    return NULL;
+    if (rtPolicy != NULL && !rtPolicy->IsEmpty())
+        return rtPolicy->Dequeue();
+    return policy->Dequeue();
 }
 
 //----------------------------------------------------------------------
@@ -201,6 +173,13 @@ void Scheduler::Run(Thread *nextThread, bool finishing)
     oldThread->CheckOverflow(); // check if the old thread
                                 // had an undetected stack overflow
 
+    if (oldThread->IsRealTime())
+        rtPolicy->Charge(oldThread);
+    if (nextThread->IsRealTime())
+        nextThread->setLastCharged(kernel->stats->totalTicks);
+
+    oldThread->getSchedStats()->SwitchedOut(oldThread->getStatus());
+
     kernel->currentThread = nextThread; // switch to the next thread
     nextThread->setStatus(RUNNING);     // nextThread is now running
 
@@ -256,63 +235,151 @@ void Scheduler::CheckToBeDestroyed()
 void Scheduler::Print()
 {
     cerr << "当前的就绪队列：\n";
-    if(typeno==0||typeno==2) readyList->Apply(ThreadPrint);
-    else if(typeno==1) sortedReadyList->Apply(ThreadPrint);
-    else if(typeno==3)
-    {
-        for(int i=0;i<QueueNum;++i)
-        {
-            cerr<<"第"<<i<<"级队列:\n";
-            threadArrQueue[i]->Apply(ThreadPrint);
-        }
-    }
+    if (rtPolicy != NULL) rtPolicy->Print();
+    policy->Print();
 }
 
 bool Scheduler::isReadyListEmpty()
 {
-    if(typeno==0||typeno==2) return readyList->IsEmpty();
-    else if(typeno==1) return sortedReadyList->IsEmpty();
-    else if(typeno==3)
-    {
-        for(int i=0;i<QueueNum;++i)
-        {
-            if(!threadArrQueue[i]->IsEmpty()) return false;
-        }
-    }
-    return true;
+    if (rtPolicy != NULL && !rtPolicy->IsEmpty()) return false;
+    return policy->IsEmpty();
 }
 
 Thread* Scheduler::getReadyListFront()
 {
-    if(typeno==0||typeno==2)
-    {
-        if (!readyList->IsEmpty()) return readyList->Front();
-    }
-    else if(typeno==1)
-    {
-        if (!sortedReadyList->IsEmpty()) return sortedReadyList->Front();
+    if (rtPolicy != NULL && !rtPolicy->IsEmpty()) return rtPolicy->Front();
+    return policy->Front();
+}
+
+//----------------------------------------------------------------------
+// Scheduler::TimerTick
+// 	Let the policy account for one timer interrupt against the
+//	running thread.  Called from Alarm::CallBack.
+//
+//	The real-time class gets the tick first, to release jobs and
+//	enforce budgets.  A real-time thread is never time-sliced by
+//	the normal policy.
+//----------------------------------------------------------------------
+
+bool Scheduler::TimerTick()
+{
+    Thread *current = kernel->currentThread;
+    MachineStatus status = kernel->interrupt->getStatus();
+
+    if (rtPolicy != NULL) {
+        if (rtPolicy->TimerTick(current, status))
+            return TRUE;
+        if (current->IsRealTime())
+            return FALSE;
     }
-    else if(typeno==3)
-    {
-        for(int i=0;i<QueueNum;++i)
-        {
-            if(!threadArrQueue[i]->IsEmpty()) return threadArrQueue[i]->Front();
-        }
+    return policy->TimerTick(current, status);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::ShouldPreempt
+// 	Ask the policy whether the running thread should give up the
+//	CPU to the thread at the front of the ready queue.
+//----------------------------------------------------------------------
+
+bool Scheduler::ShouldPreempt()
+{
+    Thread *current = kernel->currentThread;
+
+    if (rtPolicy != NULL) {
+        if (rtPolicy->ShouldPreempt(current))
+            return TRUE;
+        if (current->IsRealTime())
+            return FALSE;
     }
-    return NULL;
+    return policy->ShouldPreempt(current);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::NeedsTick
+// 	In tickless mode, the timer is only kept running while this
+//	returns TRUE: a lone runnable thread has nobody to share the CPU
+//	with, so time-slicing it would be wasted work.
+//----------------------------------------------------------------------
+
+bool Scheduler::NeedsTick()
+{
+    Thread *current = kernel->currentThread;
+
+    if (rtPolicy != NULL && rtPolicy->NeedsTick(current))
+        return TRUE;
+    return policy->NeedsTick(current);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::ChangePriority
+// 	Make "thread" run at "priority" from now on, without touching
+//	the priority it was given (see Lock, which lends priorities to
+//	lock holders).  A thread on the ready queue is moved to its new
+//	place there.
+//
+//	Interrupts must be disabled.
+//----------------------------------------------------------------------
+
+void Scheduler::ChangePriority(Thread *thread, int priority)
+{
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+
+    if (thread->getPriority() == priority)
+        return;
+    thread->inheritPriority(priority);
+    if (thread->getStatus() == READY && !thread->IsRealTime())
+        policy->Requeue(thread);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::AdmitRealTime
+// 	Run admission control for a new periodic real-time thread.
+//	The EDF class is created the first time it is needed.
+//----------------------------------------------------------------------
+
+bool Scheduler::AdmitRealTime(int period, int budget, int deadline)
+{
+    if (rtPolicy == NULL)
+        rtPolicy = new EDFPolicy();
+    return rtPolicy->Admit(period, budget, deadline);
+}
+
+void Scheduler::RetireRealTime(Thread *thread)
+{
+    rtPolicy->Retire(thread);
+}
+
+bool Scheduler::RealTimeJobDone(Thread *thread)
+{
+    return rtPolicy->JobDone(thread);
 }
 
 void Scheduler::awakeAThead()
 {
-    Thread* t = blockList->RemoveFront();
-    t->setStatus(READY);
-    readyList->Append(t);
+    ReadyToRun(blockList->RemoveFront());
 }
 
-void Scheduler::suspendAThread()
+//----------------------------------------------------------------------
+// Scheduler::suspendAThread
+// 	Write the first blocked thread that can be suspended out to disk,
+//	and move it to the suspend list.  Return FALSE if there is none.
+//
+//	The image is per thread, so a thread whose address space is
+//	shared with other live threads is skipped: giving its frames back
+//	would take the pages out from under the others, and what they
+//	wrote would be lost.
+//----------------------------------------------------------------------
+
+bool Scheduler::suspendAThread()
 {
-    Thread* t = blockList->RemoveFront();
+    Thread* t = blockList->IsEmpty() ? NULL : blockList->Front();
     char fname[100];
+
+    while (t != NULL && t->space != NULL && t->space->NumThreads() > 1)
+        t = blockList->Next(t);
+    if (t == NULL)
+        return FALSE;
+    blockList->Remove(t);
     sprintf(fname, "thread%d", t->getTID());
 #ifdef FILESYS_STUB
     kernel->fileSystem->Create(fname);
@@ -322,16 +389,19 @@ void Scheduler::suspendAThread()
     suspendList->Append(t);
     t->SaveAThread(fname);
     t->setStatus(SUSPENDED);
+    return TRUE;
 }
 
 void Scheduler::restoreAThread()
 {
+    if (suspendList->IsEmpty())
+        return;
+
     Thread* t = suspendList->RemoveFront();
     char fname[100];
     sprintf(fname,"thread%d",t->getTID());
     t->LoadAThread(fname);
-    readyList->Append(t);
-    t->setStatus(READY);
+    ReadyToRun(t);
     kernel->fileSystem->Remove(fname);
 }
 
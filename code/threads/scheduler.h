@@ -10,16 +10,14 @@
 #define SCHEDULER_H
 
 #include "copyright.h"
-#include "list.h"
+#include "ilist.h"
 #include "thread.h"
+#include "schedpolicy.h"
 
 // The following class defines the scheduler/dispatcher abstraction -- 
 // the data structures and operations needed to keep track of which 
 // thread is running, and which threads are ready but not running.
-
-const int timeSlice = 3;
-#define QueueNum 5
-const int threadArrTimeSlice[QueueNum]={3,4,5,6,7};
+// The ordering of the ready threads is left to a SchedulingPolicy.
 
 class Scheduler {
   public:
@@ -28,6 +26,9 @@ class Scheduler {
 
     void ReadyToRun(Thread* thread);	
     				// Thread can be dispatched.
+    void ReadyToRunAll(IntrusiveList<Thread> *threads);
+    				// So can all these; "threads" is
+    				// left empty
     Thread* FindNextToRun();	// Dequeue first thread on the ready 
 				// list, if any, and return thread.
     void Run(Thread* nextThread, bool finishing);
@@ -36,6 +37,24 @@ class Scheduler {
     				// running needs to be deleted
     void Print();		// Print contents of ready list
 
+    bool TimerTick();		// Called on every timer interrupt;
+    				// TRUE if the running thread should yield
+    bool ShouldPreempt();	// TRUE if the running thread should yield
+    				// to a thread that was just made ready
+    bool NeedsTick();		// does anyone need the next timer
+    				// interrupt?  (tickless mode)
+    void ChangePriority(Thread *thread, int priority);
+    				// set the priority "thread" runs at,
+    				// keeping the ready queue sorted
+
+    bool AdmitRealTime(int period, int budget, int deadline);
+    				// admission control for the EDF class
+    void RetireRealTime(Thread *thread);
+    				// a real-time thread is finishing
+    bool RealTimeJobDone(Thread *thread);
+    				// TRUE if "thread" must sleep until
+    				// its next release
+
     bool isReadyListEmpty();
 
     bool isBlockListEmpty() { return blockList->IsEmpty(); }
@@ -50,16 +69,18 @@ class Scheduler {
 
     void restoreAThread();
 
-    void suspendAThread();
+    bool suspendAThread();		// FALSE if no blocked thread can
+    					// be written out
     
     // SelfTest for scheduler is implemented in class Thread
     
   private:
-    List<Thread*>* threadArrQueue[QueueNum];
-    SortedList<Thread *> *sortedReadyList;  // queue of threads that are ready to run, but not running
-    List<Thread *> *readyList;  // queue of threads that are ready to run, but not running
-    List<Thread *> *suspendList;
-    List<Thread*> *blockList;
+    SchedulingPolicy *policy;	// owns the queue(s) of threads that are
+    				// ready to run, but not running
+    EDFPolicy *rtPolicy;	// real-time threads; NULL until the first
+    				// one is admitted
+    IntrusiveList<Thread> *suspendList;
+    IntrusiveList<Thread> *blockList;
     Thread *toBeDestroyed;	// finishing thread to be destroyed by the next thread that runs
 };
 
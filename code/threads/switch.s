@@ -11,6 +11,7 @@
  *	    SUN SPARC (SPARC)
  *	    HP PA-RISC (PARISC)
  *	    Intel 386 (x86)
+ *	    Intel x86-64 (x86_64)
  *	    IBM RS6000 (PowerPC) -- I hope it will also work for Mac PowerPC
  *
  * We define two routines for each architecture:
@@ -375,6 +376,71 @@ SWITCH:
 #endif // x86
 
 
+#ifdef x86_64
+
+        .text
+        .align  16
+
+        .globl  ThreadRoot
+
+/* void ThreadRoot( void )
+**
+** expects the following registers to be initialized:
+**      r15     points to startup function (interrupt enable)
+**      r13     contains inital argument to thread function
+**      r12     points to thread function
+**      r14     point to Thread::Finish()
+**
+** SWITCH "returns" here with the stack aligned as if ThreadRoot had
+** been called, so the calls below see a 16-byte aligned stack.
+*/
+ThreadRoot:
+        pushq   %rbp
+        movq    %rsp,%rbp
+        call    *StartupPC
+        movq    InitialArg,%rdi
+        call    *InitialPC
+        call    *WhenDonePC
+
+ /*       # NOT REACHED */
+        movq    %rbp,%rsp
+        popq    %rbp
+        ret
+
+/* void SWITCH( thread *t1, thread *t2 )
+**
+** t1 is in rdi, t2 in rsi; (rsp) is the return address.
+** Only the callee-saved registers are switched.
+*/
+        .globl  SWITCH
+SWITCH:
+        movq    %rsp,_RSP(%rdi)         # save stack pointer
+        movq    %rbx,_RBX(%rdi)         # save registers
+        movq    %rbp,_RBP(%rdi)
+        movq    %r12,_R12(%rdi)
+        movq    %r13,_R13(%rdi)
+        movq    %r14,_R14(%rdi)
+        movq    %r15,_R15(%rdi)
+        movq    (%rsp),%rax             # save the return address
+        movq    %rax,_PC(%rdi)
+
+        movq    _RBX(%rsi),%rbx         # restore registers
+        movq    _RBP(%rsi),%rbp
+        movq    _R12(%rsi),%r12
+        movq    _R13(%rsi),%r13
+        movq    _R14(%rsi),%r14
+        movq    _R15(%rsi),%r15
+        movq    _RSP(%rsi),%rsp         # restore stack pointer
+        movq    _PC(%rsi),%rax          # copy over the ret address on the stack
+        movq    %rax,(%rsp)
+        ret
+
+/* the stack does not need to be executable */
+        .section .note.GNU-stack,"",@progbits
+
+#endif // x86_64
+
+
 #if defined(ApplePowerPC)
 
 	/* The AIX PowerPC code is incompatible with the assembler on MacOS X
@@ -1,7 +1,7 @@
 // synch.cc
-//	Routines for synchronizing threads.  Three kinds of
-//	synchronization routines are defined here: semaphores, locks
-//   	and condition variables.
+//	Routines for synchronizing threads.  Five kinds of
+//	synchronization routines are defined here: semaphores, locks,
+//   	condition variables, reader-writer locks and barriers.
 //
 // Any implementation of a synchronization routine needs some
 // primitive atomic operation.  We assume Nachos is running on
@@ -18,15 +18,24 @@
 //
 // Once we'e implemented one set of higher level atomic operations,
 // we can implement others using that implementation.  We illustrate
-// this by implementing locks and condition variables on top of
-// semaphores, instead of directly enabling and disabling interrupts.
+// this by implementing locks on top of semaphores, instead of
+// directly enabling and disabling interrupts.
 //
 // Locks are implemented using a semaphore to keep track of
 // whether the lock is held or not -- a semaphore value of 0 means
 // the lock is busy; a semaphore value of 1 means the lock is free.
+// For priority inheritance, a lock also looks at the threads
+// waiting on its semaphore.
 //
-// The implementation of condition variables using semaphores is
-// a bit trickier, as explained below under Condition::Wait.
+// Condition variables, on the other hand, keep their own queue of
+// waiting threads and put them to sleep directly, like semaphores
+// do, so that waiting does not cost a semaphore per waiter; see
+// Condition::Wait.
+//
+// Reader-writer locks and barriers work like semaphores too:
+// interrupts off, and waiters sleeping on queues of their own.  Their
+// bookkeeping is more than a semaphore's value, though, so they do not
+// use one.
 //
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation
@@ -34,6 +43,7 @@
 
 #include "copyright.h"
 #include "synch.h"
+#include "lockstats.h"
 #include "main.h"
 
 //----------------------------------------------------------------------
@@ -48,7 +58,10 @@ Semaphore::Semaphore(char *debugName, int initialValue)
 {
     name = debugName;
     value = initialValue;
-    queue = new List<Thread *>;
+    queue = new IntrusiveList<Thread>(&Thread::queueLink);
+    profile = NULL;
+    if (kernel->lockProfiler != NULL)
+        profile = kernel->lockProfiler->Lookup(debugName, "semaphore");
 }
 
 //----------------------------------------------------------------------
@@ -79,6 +92,8 @@ void Semaphore::P()
 
     // disable interrupts
     IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int start = kernel->stats->totalTicks;
+    bool contended = (value == 0);
 
     while (value == 0)
     {                                 // semaphore not available
@@ -86,6 +101,8 @@ void Semaphore::P()
         currentThread->Sleep(FALSE);
     }
     value--; // semaphore available, consume its value
+    if (profile != NULL)
+        profile->Acquired(contended, kernel->stats->totalTicks - start);
 
     // re-enable interrupts
     (void)interrupt->SetLevel(oldLevel);
@@ -156,11 +173,16 @@ void Semaphore::SelfTest()
 //	"debugName" is an arbitrary name, useful for debugging.
 //----------------------------------------------------------------------
 
-Lock::Lock(char *debugName)
+Lock::Lock(char *debugName) : heldLink(this)
 {
     name = debugName;
     semaphore = new Semaphore("lock", 1); // initially, unlocked
+    semaphore->profile = NULL; // accounted for as a lock, not twice
     lockHolder = NULL;
+    profile = NULL;
+    if (kernel->lockProfiler != NULL)
+        profile = kernel->lockProfiler->Lookup(debugName, "lock");
+    acquiredAt = 0;
 }
 
 //----------------------------------------------------------------------
@@ -181,8 +203,35 @@ Lock::~Lock()
 
 void Lock::Acquire()
 {
+    Thread *currentThread = kernel->currentThread;
+    int start = kernel->stats->totalTicks;
+    bool contended = (lockHolder != NULL);
+
+    if (typeno != 1)
+    {
+        semaphore->P();
+        lockHolder = currentThread;
+        acquiredAt = kernel->stats->totalTicks;
+        if (profile != NULL)
+            profile->Acquired(contended, acquiredAt - start);
+        return;
+    }
+
+    IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+    if (lockHolder != NULL)
+    {
+        currentThread->waitingFor = this;
+        Donate(currentThread->getPriority());
+    }
     semaphore->P();
-    lockHolder = kernel->currentThread;
+    currentThread->waitingFor = NULL;
+    lockHolder = currentThread;
+    acquiredAt = kernel->stats->totalTicks;
+    if (profile != NULL)
+        profile->Acquired(contended, acquiredAt - start);
+    currentThread->heldLocks.Append(this);
+    UpdatePriority(currentThread); // others may be waiting already
+    (void)kernel->interrupt->SetLevel(oldLevel);
 }
 
 //----------------------------------------------------------------------
@@ -198,9 +247,104 @@ void Lock::Acquire()
 
 void Lock::Release()
 {
+    Thread *currentThread = kernel->currentThread;
+
     ASSERT(IsHeldByCurrentThread());
+    if (profile != NULL)
+        profile->Released(kernel->stats->totalTicks - acquiredAt);
+    if (typeno != 1)
+    {
+        lockHolder = NULL;
+        semaphore->V();
+        return;
+    }
+
+    IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+    Thread *next = TopWaiter();
+    currentThread->heldLocks.Remove(this);
     lockHolder = NULL;
+    if (next != NULL)
+    { // V wakes up the front waiter: make it the most urgent one
+        semaphore->queue->Remove(next);
+        semaphore->queue->Prepend(next);
+    }
     semaphore->V();
+    UpdatePriority(currentThread);
+    (void)kernel->interrupt->SetLevel(oldLevel);
+
+    // we may be back to a lower priority than the thread we just woke
+    // up; but not from inside Condition::Wait, which is about to sleep
+    if (oldLevel == IntOn && kernel->scheduler->ShouldPreempt())
+        currentThread->Yield();
+}
+
+//----------------------------------------------------------------------
+// Lock::Donate
+//	The current thread, running at "priority", is about to wait for
+//	this lock.  Raise the holder to that priority if it runs at a
+//	lower one; and if the holder is itself waiting for a lock, do
+//	the same for that lock's holder, and so on down the chain.
+//	(Smaller numbers are more urgent.)
+//
+//	Interrupts must be disabled.
+//----------------------------------------------------------------------
+
+void Lock::Donate(int priority)
+{
+    for (Lock *lock = this; lock != NULL && lock->lockHolder != NULL;
+         lock = lock->lockHolder->waitingFor)
+    {
+        Thread *holder = lock->lockHolder;
+
+        if (holder->getPriority() <= priority)
+            break;	// the rest of the chain is at least as urgent
+        DEBUG(dbgThread, "Lending priority " << priority << " to " << holder->getName());
+        kernel->scheduler->ChangePriority(holder, priority);
+    }
+}
+
+//----------------------------------------------------------------------
+// Lock::TopWaiter
+//	Return the most urgent thread waiting for the lock, the first
+//	one to come among equals, or NULL if no one is waiting.
+//----------------------------------------------------------------------
+
+Thread *Lock::TopWaiter()
+{
+    IntrusiveList<Thread> *queue = semaphore->queue;
+    Thread *top = NULL;
+
+    for (Thread *t = queue->IsEmpty() ? NULL : queue->Front(); t != NULL;
+         t = queue->Next(t))
+    {
+        if (top == NULL || t->getPriority() < top->getPriority())
+            top = t;
+    }
+    return top;
+}
+
+//----------------------------------------------------------------------
+// Lock::UpdatePriority
+//	Set the priority "thread" runs at to its own, or to that of the
+//	most urgent thread waiting for one of the locks it holds, if
+//	that is more urgent.
+//
+//	Interrupts must be disabled.
+//----------------------------------------------------------------------
+
+void Lock::UpdatePriority(Thread *thread)
+{
+    IntrusiveList<Lock> *held = &thread->heldLocks;
+    int priority = thread->getBasePriority();
+
+    for (Lock *lock = held->IsEmpty() ? NULL : held->Front(); lock != NULL;
+         lock = held->Next(lock))
+    {
+        Thread *top = lock->TopWaiter();
+        if (top != NULL && top->getPriority() < priority)
+            priority = top->getPriority();
+    }
+    kernel->scheduler->ChangePriority(thread, priority);
 }
 
 //----------------------------------------------------------------------
@@ -214,8 +358,11 @@ void Lock::Release()
 Condition::Condition(char *debugName)
 {
     name = debugName;
-    waitQueue = new List<Semaphore *>;
+    waitQueue = new IntrusiveList<Thread>(&Thread::queueLink);
     barrierNum = 0;
+    profile = NULL;
+    if (kernel->lockProfiler != NULL)
+        profile = kernel->lockProfiler->Lookup(debugName, "condition");
 }
 
 //----------------------------------------------------------------------
@@ -231,11 +378,10 @@ Condition::~Condition()
 //----------------------------------------------------------------------
 // Condition::Wait
 // 	Atomically release monitor lock and go to sleep.
-//	Our implementation uses semaphores to implement this, by
-//	allocating a semaphore for each waiting thread.  The signaller
-//	will V() this semaphore, so there is no chance the waiter
-//	will miss the signal, even though the lock is released before
-//	calling P().
+//	The waiting thread itself goes on the wait queue, and interrupts
+//	stay off from before the lock is released until the thread is
+//	asleep, so there is no chance the waiter will miss the signal.
+//	Nothing is allocated.
 //
 //	Note: we assume Mesa-style semantics, which means that the
 //	waiter must re-acquire the monitor lock when waking up.
@@ -245,16 +391,20 @@ Condition::~Condition()
 
 void Condition::Wait(Lock *conditionLock)
 {
-    Semaphore *waiter;
+    Interrupt *interrupt = kernel->interrupt;
+    Thread *currentThread = kernel->currentThread;
 
     ASSERT(conditionLock->IsHeldByCurrentThread());
 
-    waiter = new Semaphore("condition", 0);
-    waitQueue->Append(waiter);
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int start = kernel->stats->totalTicks;
+    waitQueue->Append(currentThread);
     conditionLock->Release();
-    waiter->P();
+    currentThread->Sleep(FALSE);
+    if (profile != NULL)
+        profile->Acquired(TRUE, kernel->stats->totalTicks - start);
+    (void)interrupt->SetLevel(oldLevel);
     conditionLock->Acquire();
-    delete waiter;
 }
 
 //----------------------------------------------------------------------
@@ -267,42 +417,438 @@ void Condition::Wait(Lock *conditionLock)
 //
 //	Also note: we assume the caller holds the monitor lock
 //	(unlike what is described in Birrell's paper).  This allows
-//	us to access waitQueue without disabling interrupts.
+//	us to look at waitQueue without disabling interrupts; they are
+//	only turned off to hand a waiter to the scheduler.
 //
 //	"conditionLock" -- lock protecting the use of this condition
 //----------------------------------------------------------------------
 
 void Condition::Signal(Lock *conditionLock)
 {
-    Semaphore *waiter;
-
     ASSERT(conditionLock->IsHeldByCurrentThread());
 
-    if (!waitQueue->IsEmpty())
-    {
-        waiter = waitQueue->RemoveFront();
-        waiter->V();
-    }
+    if (waitQueue->IsEmpty())
+        return;
+    IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+    kernel->scheduler->ReadyToRun(waitQueue->RemoveFront());
+    (void)kernel->interrupt->SetLevel(oldLevel);
 }
 
 //----------------------------------------------------------------------
 // Condition::Broadcast
-// 	Wake up all threads waiting on this condition, if any.
+// 	Wake up all threads waiting on this condition, if any.  The
+//	whole wait queue is handed to the scheduler at once.
 //
 //	"conditionLock" -- lock protecting the use of this condition
 //----------------------------------------------------------------------
 
 void Condition::Broadcast(Lock *conditionLock)
 {
-    while (!waitQueue->IsEmpty())
-    {
-        Signal(conditionLock);
-    }
+    ASSERT(conditionLock->IsHeldByCurrentThread());
+
+    if (waitQueue->IsEmpty())
+        return;
+    IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+    kernel->scheduler->ReadyToRunAll(waitQueue);
+    (void)kernel->interrupt->SetLevel(oldLevel);
 }
 
+//----------------------------------------------------------------------
+// Condition::Barrier
+// 	Wait until BARRIER_NUM threads have called Barrier; the last one
+//	wakes the others up, and the count starts over for the next use.
+//
+//	"conditionLock" -- lock protecting the use of this condition
+//----------------------------------------------------------------------
+
 void Condition::Barrier(Lock *conditionLock)
 {
     ++barrierNum;
-    if(barrierNum == BARRIER_NUM) Broadcast(conditionLock);
+    if(barrierNum == BARRIER_NUM)
+    {
+        barrierNum = 0;
+        Broadcast(conditionLock);
+    }
     else Wait(conditionLock);
-}
\ No newline at end of file
+}
+//----------------------------------------------------------------------
+// RWLock::RWLock
+// 	Initialize a reader-writer lock.  Initially, unlocked.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//	"rwPolicy" says who goes first when readers and writers are
+//	both waiting.
+//----------------------------------------------------------------------
+
+RWLock::RWLock(char *debugName, RWPolicy rwPolicy)
+{
+    name = debugName;
+    policy = rwPolicy;
+    readers = 0;
+    writer = NULL;
+    upgrader = NULL;
+    nextTicket = 0;
+    readQueue = new IntrusiveList<RWWaiter>(&RWWaiter::link);
+    writeQueue = new IntrusiveList<RWWaiter>(&RWWaiter::link);
+}
+
+//----------------------------------------------------------------------
+// RWLock::~RWLock
+// 	Deallocate a reader-writer lock.  Assume no one holds it or is
+//	waiting for it!
+//----------------------------------------------------------------------
+
+RWLock::~RWLock()
+{
+    ASSERT(readers == 0 && writer == NULL);
+    delete readQueue;
+    delete writeQueue;
+}
+
+//----------------------------------------------------------------------
+// RWLock::Wait
+// 	Put the current thread to sleep on "queue" until some other
+//	thread hands it the lock; the one waking us up has already
+//	done the bookkeeping.  The waiter lives on our stack, so
+//	nothing is allocated.
+//
+//	Interrupts must be disabled.
+//----------------------------------------------------------------------
+
+void RWLock::Wait(IntrusiveList<RWWaiter> *queue)
+{
+    RWWaiter waiter(kernel->currentThread, nextTicket++);
+
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+    queue->Append(&waiter);
+    kernel->currentThread->Sleep(FALSE);
+    ASSERT(!waiter.link.IsLinked());
+}
+
+//----------------------------------------------------------------------
+// RWLock::WriterGoesFirst
+// 	Decide whether the next thread to get the lock is the writer at
+//	the front of writeQueue, rather than the readers on readQueue.
+//----------------------------------------------------------------------
+
+bool RWLock::WriterGoesFirst()
+{
+    if (writeQueue->IsEmpty())
+        return FALSE;
+    if (readQueue->IsEmpty())
+        return TRUE;
+    switch (policy)
+    {
+    case RWReaderPreference:
+        return FALSE;
+    case RWWriterPreference:
+        return TRUE;
+    default:
+        return (int)(writeQueue->Front()->ticket - readQueue->Front()->ticket) < 0;
+    }
+}
+
+//----------------------------------------------------------------------
+// RWLock::WakeWaiters
+// 	Something changed: hand the lock to whoever can have it now.
+//	A reader waiting in Upgrade comes first, as soon as it is the
+//	only reader left.  Otherwise either one writer gets the lock,
+//	once the readers are gone, or the readers do; with RWFair, only
+//	those that came before the first waiting writer.
+//
+//	Interrupts must be disabled.
+//----------------------------------------------------------------------
+
+void RWLock::WakeWaiters()
+{
+    Scheduler *scheduler = kernel->scheduler;
+
+    if (upgrader != NULL)
+    {
+        if (readers == 1)
+        {
+            readers = 0;
+            writer = upgrader;
+            upgrader = NULL;
+            scheduler->ReadyToRun(writer);
+        }
+        return;
+    }
+    if (writer != NULL)
+        return;
+
+    if (WriterGoesFirst())
+    {
+        if (readers == 0)
+        {
+            writer = writeQueue->RemoveFront()->thread;
+            scheduler->ReadyToRun(writer);
+        }
+        return;
+    }
+    while (!readQueue->IsEmpty())
+    {
+        RWWaiter *waiter = readQueue->Front();
+
+        if (policy == RWFair && !writeQueue->IsEmpty() &&
+            (int)(writeQueue->Front()->ticket - waiter->ticket) < 0)
+            break;
+        readQueue->RemoveFront();
+        readers++;
+        scheduler->ReadyToRun(waiter->thread);
+    }
+}
+
+//----------------------------------------------------------------------
+// RWLock::AcquireRead
+// 	Wait until the lock can be shared, then join the readers.  A
+//	reader never gets in ahead of a thread already waiting, except
+//	with RWReaderPreference, where only a writer holding the lock
+//	(or a reader upgrading) keeps it out.
+//----------------------------------------------------------------------
+
+void RWLock::AcquireRead()
+{
+    IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+
+    if (writer == NULL && upgrader == NULL &&
+        (policy == RWReaderPreference ||
+         (readQueue->IsEmpty() && writeQueue->IsEmpty())))
+        readers++;
+    else
+        Wait(readQueue);
+
+    (void)kernel->interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// RWLock::ReleaseRead
+// 	Leave the readers; the last one out lets the next writer in.
+//----------------------------------------------------------------------
+
+void RWLock::ReleaseRead()
+{
+    IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+
+    ASSERT(readers > 0 && writer == NULL);
+    readers--;
+    if (readers <= 1)
+        WakeWaiters();
+
+    (void)kernel->interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// RWLock::AcquireWrite
+// 	Wait until no one else holds the lock, then take it.
+//----------------------------------------------------------------------
+
+void RWLock::AcquireWrite()
+{
+    IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+
+    ASSERT(!IsWriteHeldByCurrentThread());
+    if (writer == NULL && readers == 0 && upgrader == NULL &&
+        readQueue->IsEmpty() && writeQueue->IsEmpty())
+        writer = kernel->currentThread;
+    else
+        Wait(writeQueue);
+    ASSERT(IsWriteHeldByCurrentThread());
+
+    (void)kernel->interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// RWLock::ReleaseWrite
+// 	Free the lock, waking up whoever is next.
+//
+//	Only the thread that acquired the lock for writing may release
+//	it.
+//----------------------------------------------------------------------
+
+void RWLock::ReleaseWrite()
+{
+    IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+
+    ASSERT(IsWriteHeldByCurrentThread());
+    writer = NULL;
+    WakeWaiters();
+
+    (void)kernel->interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// RWLock::Upgrade
+// 	Turn our read hold into a write hold.  New readers are kept out
+//	from now on, and we wait for the other readers to leave; we get
+//	the lock before any writer that is already waiting, since
+//	making us wait behind it would mean giving up what we read.
+//
+//	Returns FALSE, still holding the lock for reading, if another
+//	reader is upgrading already.
+//----------------------------------------------------------------------
+
+bool RWLock::Upgrade()
+{
+    IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+    bool upgraded = TRUE;
+
+    ASSERT(readers > 0 && writer == NULL);
+    if (upgrader != NULL)
+        upgraded = FALSE;
+    else if (readers == 1)
+    {
+        readers = 0;
+        writer = kernel->currentThread;
+    }
+    else
+    {
+        upgrader = kernel->currentThread;
+        kernel->currentThread->Sleep(FALSE);
+        ASSERT(IsWriteHeldByCurrentThread());
+    }
+
+    (void)kernel->interrupt->SetLevel(oldLevel);
+    return upgraded;
+}
+
+//----------------------------------------------------------------------
+// RWLock::Downgrade
+// 	Turn our write hold into a read hold, letting in the readers
+//	that may come in alongside us.  The lock is never free in
+//	between, so what we wrote is what we keep reading.
+//----------------------------------------------------------------------
+
+void RWLock::Downgrade()
+{
+    IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+
+    ASSERT(IsWriteHeldByCurrentThread());
+    writer = NULL;
+    readers = 1;
+    WakeWaiters();
+
+    (void)kernel->interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Barrier::Barrier
+// 	Initialize a barrier for "count" threads, and build its
+//	combining tree, one level at a time from the leaves up.  This is
+//	the only place a barrier allocates anything.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//	"fanIn" is the number of threads per leaf and of children per
+//	node; 0 for a flat barrier.
+//----------------------------------------------------------------------
+
+Barrier::Barrier(char *debugName, int count, int fanIn)
+{
+    ASSERT(count > 0);
+    ASSERT(fanIn == 0 || fanIn >= 2);
+    name = debugName;
+    this->count = count;
+    this->fanIn = (fanIn == 0 || fanIn > count) ? count : fanIn;
+    if (this->fanIn < 2)
+        this->fanIn = 2;
+    sense = FALSE;
+    arrivals = 0;
+
+    numNodes = 0;
+    for (int width = count; width > 1 || numNodes == 0;)
+    {
+        width = divRoundUp(width, this->fanIn);
+        numNodes += width;
+    }
+    nodes = new BarrierNode[numNodes];
+
+    int first = 0;		// first node of the current level
+    int arriving = count;	// threads or nodes arriving at it
+    for (;;)
+    {
+        int width = divRoundUp(arriving, this->fanIn);
+        for (int i = 0; i < width; i++)
+        {
+            BarrierNode *node = &nodes[first + i];
+
+            node->count = node->remaining =
+                min(this->fanIn, arriving - i * this->fanIn);
+            node->parent = (width == 1) ? NULL
+                : &nodes[first + width + i / this->fanIn];
+            node->waiters = new IntrusiveList<Thread>(&Thread::queueLink);
+        }
+        if (width == 1)
+            break;
+        first += width;
+        arriving = width;
+    }
+    ASSERT(first + 1 == numNodes);
+}
+
+//----------------------------------------------------------------------
+// Barrier::~Barrier
+// 	Deallocate a barrier.  Assume no one is waiting at it!
+//----------------------------------------------------------------------
+
+Barrier::~Barrier()
+{
+    for (int i = 0; i < numNodes; i++)
+    {
+        ASSERT(nodes[i].waiters->IsEmpty());
+        delete nodes[i].waiters;
+    }
+    delete [] nodes;
+}
+
+//----------------------------------------------------------------------
+// Barrier::Wait
+// 	Arrive at the leaf for our place in this phase, and climb the
+//	tree for as long as we are the last to arrive at a node.  At the
+//	first node where others are still missing, sleep until the phase
+//	is over.  The thread that completes the root ends the phase.
+//
+//	On the way out, wake up the threads asleep at each node we were
+//	the last to arrive at, from the top down.
+//----------------------------------------------------------------------
+
+void Barrier::Wait()
+{
+    Thread *currentThread = kernel->currentThread;
+    IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+    bool mySense = !sense;
+    BarrierNode *won[BarrierMaxDepth];	// nodes we completed
+    int numWon = 0;
+
+    ASSERT(arrivals < count);
+    BarrierNode *node = &nodes[arrivals++ / fanIn];
+    for (;;)
+    {
+        if (--node->remaining > 0)
+        {
+            while (sense != mySense)
+            {
+                node->waiters->Append(currentThread);
+                currentThread->Sleep(FALSE);
+            }
+            break;
+        }
+        node->remaining = node->count;	// ready for the next phase
+        ASSERT(numWon < BarrierMaxDepth);
+        won[numWon++] = node;
+        if (node->parent == NULL)
+        {
+            arrivals = 0;
+            sense = mySense;	// the phase is over
+            break;
+        }
+        node = node->parent;
+    }
+
+    while (numWon > 0)
+    {
+        node = won[--numWon];
+        if (!node->waiters->IsEmpty())
+            kernel->scheduler->ReadyToRunAll(node->waiters);
+    }
+    (void)kernel->interrupt->SetLevel(oldLevel);
+}
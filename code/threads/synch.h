@@ -1,8 +1,8 @@
 // synch.h 
 //	Data structures for synchronizing threads.
 //
-//	Three kinds of synchronization are defined here: semaphores,
-//	locks, and condition variables.
+//	Five kinds of synchronization are defined here: semaphores,
+//	locks, condition variables, reader-writer locks and barriers.
 //
 //	Note that all the synchronization objects take a "name" as
 //	part of the initialization.  This is solely for debugging purposes.
@@ -17,10 +17,13 @@
 #include "copyright.h"
 #include "thread.h"
 #include "list.h"
+#include "ilist.h"
 #include "main.h"
 
 #define BARRIER_NUM 5
 
+class LockStats;
+
 // The following class defines a "semaphore" whose value is a non-negative
 // integer.  The semaphore has only two operations P() and V():
 //
@@ -49,8 +52,12 @@ class Semaphore {
   private:
     char* name;        // useful for debugging
     int value;         // semaphore value, always >= 0
-    List<Thread *> *queue;     
+    IntrusiveList<Thread> *queue;
 		  	// threads waiting in P() for the value to be > 0
+    LockStats *profile;	// contention accounting, if "-lp"
+
+    friend class Lock;	// looks at who is waiting, for priority
+    			// inheritance
    };
 
 // The following class defines a "lock".  A lock can be BUSY or FREE.
@@ -64,6 +71,13 @@ class Semaphore {
 // In addition, by convention, only the thread that acquired the lock
 // may release it.  As with semaphores, you can't read the lock value
 // (because the value might change immediately after you read it).  
+//
+// Under priority scheduling (typeno 1), a thread waiting for a lock
+// lends its priority to the holder, and on to whoever the holder is
+// waiting for in turn, so that a low-priority holder cannot be kept
+// off the CPU by medium-priority threads while a high-priority thread
+// waits.  The holder runs at its own priority again once it has
+// released every lock a more urgent thread is waiting for.
 
 class Lock {
   public:
@@ -80,11 +94,22 @@ class Lock {
 				// holds this lock.
     
     // Note: SelfTest routine provided by SynchList
+
+    ListLink<Lock> heldLink;	// on lockHolder->heldLocks
     
   private:
     char *name;			// debugging assist
     Thread *lockHolder;		// thread currently holding lock
     Semaphore *semaphore;	// we use a semaphore to implement lock
+    LockStats *profile;		// contention accounting, if "-lp"
+    int acquiredAt;		// when lockHolder got the lock
+
+    void Donate(int priority);	// lend "priority" down the chain of
+				// holders, starting with ours
+    Thread *TopWaiter();	// the most urgent thread waiting, or NULL
+    static void UpdatePriority(Thread *thread);
+				// recompute the priority "thread" runs
+				// at, from the locks it holds
 };
 
 // The following class defines a "condition variable".  A condition
@@ -134,7 +159,8 @@ class Condition {
 					// lock and going to sleep are 
 					// *atomic* in Wait()
     void Signal(Lock *conditionLock);   // conditionLock must be held by
-    void Barrier(Lock *conditionLock);
+    void Barrier(Lock *conditionLock);	// BARRIER_NUM threads only;
+					// see class Barrier for more
     void Broadcast(Lock *conditionLock);// the currentThread for all of 
 					// these operations
     // SelfTest routine provided by SyncLists
@@ -142,6 +168,135 @@ class Condition {
   private:
     char* name;
     int barrierNum;
-    List<Semaphore *> *waitQueue;	// list of waiting threads
+    IntrusiveList<Thread> *waitQueue;	// threads waiting on the condition
+    LockStats *profile;			// contention accounting, if "-lp"
+};
+
+// The following class defines a "reader-writer lock".  Any number of
+// readers may hold it at the same time, or a single writer.
+//
+//	AcquireRead/ReleaseRead -- shared access
+//
+//	AcquireWrite/ReleaseWrite -- exclusive access
+//
+//	Upgrade -- turn a read hold into a write hold, waiting for the
+//		other readers to leave.  Only one reader can be
+//		upgrading at a time; if another one already is, Upgrade
+//		returns FALSE and the caller still holds the lock for
+//		reading (it has to release it and start over, or the two
+//		would wait for each other forever).
+//
+//	Downgrade -- turn a write hold into a read hold, letting waiting
+//		readers in as well, without ever leaving the lock free.
+//
+// The "policy" decides who gets the lock when both readers and writers
+// are waiting:
+//
+//	RWReaderPreference -- readers get in whenever no writer holds
+//		the lock; writers can starve.
+//	RWWriterPreference -- a waiting writer keeps new readers out;
+//		readers can starve.
+//	RWFair -- first come, first served, except that all the readers
+//		queued before the next writer get in together.
+//
+// The lock is handed over directly to the threads it wakes up, so a
+// thread arriving later can never barge in ahead of them.
+
+enum RWPolicy { RWReaderPreference, RWWriterPreference, RWFair };
+
+// One thread waiting on an RWLock.  It lives on the waiting thread's
+// stack.
+
+class RWWaiter {
+  public:
+    RWWaiter(Thread *t, unsigned int n) : link(this) { thread = t; ticket = n; }
+
+    Thread *thread;
+    unsigned int ticket;	// arrival order, for RWFair
+    ListLink<RWWaiter> link;
+};
+
+class RWLock {
+  public:
+    RWLock(char* debugName, RWPolicy rwPolicy = RWFair);
+    ~RWLock();
+    char* getName() { return name; }
+
+    void AcquireRead();
+    void ReleaseRead();
+    void AcquireWrite();
+    void ReleaseWrite();
+    bool Upgrade();		// read -> write; FALSE if another reader
+				// is already upgrading
+    void Downgrade();		// write -> read
+
+    bool IsWriteHeldByCurrentThread() {
+		return writer == kernel->currentThread; }
+
+  private:
+    char *name;			// debugging assist
+    RWPolicy policy;
+    int readers;		// threads holding the lock for reading
+    Thread *writer;		// thread holding it for writing, or NULL
+    Thread *upgrader;		// reader waiting in Upgrade, or NULL
+    unsigned int nextTicket;
+    IntrusiveList<RWWaiter> *readQueue;	// threads waiting to read
+    IntrusiveList<RWWaiter> *writeQueue;	// threads waiting to write
+
+    bool WriterGoesFirst();	// whom to let in next
+    void WakeWaiters();		// hand the lock to whoever can have it
+    void Wait(IntrusiveList<RWWaiter> *queue);
+				// sleep on "queue" until handed the lock
+};
+
+// The following class defines a reusable "barrier" for a fixed number
+// of threads.  Wait() returns once all of them have called it; then
+// the barrier is ready for the next phase at once.
+//
+// The barrier uses sense reversal: every phase flips "sense", and a
+// waiting thread knows it may go on when the sense is no longer the
+// one it arrived in.  So a fast thread that reaches the next phase
+// before the slow ones have even woken up cannot be confused with
+// them, and nothing has to be reset between phases.
+//
+// With a "fanIn", the threads are combined in a tree: they arrive in
+// groups of fanIn at the leaves, the last thread of each group goes on
+// to arrive at the node above, and so on up to the root.  When the
+// last thread arrives at the root, it wakes up only the fanIn - 1
+// threads waiting there; each of those wakes up the threads of the
+// node below it that it was last at, and so on.  Instead of one thread
+// making every other thread ready at once, the wake-ups are spread out
+// over the threads, fanIn - 1 at a time.  A fanIn of 0 means a single
+// node: a flat barrier.
+
+#define BarrierMaxDepth 32	// levels of the combining tree, at most
+
+class BarrierNode {
+  public:
+    int count;			// threads arriving here per phase
+    int remaining;		// threads yet to arrive this phase
+    BarrierNode *parent;	// NULL for the root
+    IntrusiveList<Thread> *waiters;	// threads asleep here
+};
+
+class Barrier {
+  public:
+    Barrier(char* debugName, int count, int fanIn = 0);
+				// "count" threads; fanIn >= 2 for
+				// a combining tree
+    ~Barrier();
+    char* getName() { return name; }
+
+    void Wait();		// wait for the other threads to
+				// arrive too
+
+  private:
+    char *name;			// debugging assist
+    int count;			// number of threads
+    int fanIn;			// threads per leaf, and children per node
+    bool sense;			// flipped every phase
+    int arrivals;		// threads that arrived this phase
+    int numNodes;
+    BarrierNode *nodes;		// the leaves first, the root last
 };
 #endif // SYNCH_H
@@ -17,14 +17,20 @@
 //	Allocate and initialize the data structures needed for a
 //	synchronized list, empty to start with.
 //	Elements can now be added to the list.
+//
+//	"capacity" is the most items the list may hold; 0 means there is
+//	no limit, and Append never waits.
 //----------------------------------------------------------------------
 
 template <class T>
-SynchList<T>::SynchList()
+SynchList<T>::SynchList(int capacity)
 {
+    ASSERT(capacity >= 0);
+    this->capacity = capacity;
     list = new List<T>;
     lock = new Lock("list lock");
     listEmpty = new Condition("list empty cond");
+    listFull = new Condition("list full cond");
 }
 
 //----------------------------------------------------------------------
@@ -35,6 +41,7 @@ SynchList<T>::SynchList()
 template <class T>
 SynchList<T>::~SynchList()
 {
+    delete listFull;
     delete listEmpty;
     delete lock;
     delete list;
@@ -42,8 +49,9 @@ SynchList<T>::~SynchList()
 
 //----------------------------------------------------------------------
 // SynchList<T>::Append
-//      Append an "item" to the end of the list.  Wake up anyone
-//	waiting for an element to be appended.
+//      Append an "item" to the end of the list, first waiting for room
+//	if the list is full.  Wake up anyone waiting for an element to
+//	be appended.
 //
 //	"item" is the thing to put on the list.
 //----------------------------------------------------------------------
@@ -52,11 +60,75 @@ template <class T>
 void SynchList<T>::Append(T item)
 {
     lock->Acquire(); // enforce mutual exclusive access to the list
+    while (IsFull())
+        listFull->Wait(lock); // wait until there is room
     list->Append(item);
     listEmpty->Signal(lock); // wake up a waiter, if any
     lock->Release();
 }
 
+//----------------------------------------------------------------------
+// SynchList<T>::TryAppend
+//      Append an "item" to the end of the list, unless the list is
+//	full.  Never waits.
+//
+// Returns:
+//	TRUE if the item was appended.
+//----------------------------------------------------------------------
+
+template <class T>
+bool SynchList<T>::TryAppend(T item)
+{
+    bool appended = FALSE;
+
+    lock->Acquire();
+    if (!IsFull())
+    {
+        list->Append(item);
+        listEmpty->Signal(lock);
+        appended = TRUE;
+    }
+    lock->Release();
+    return appended;
+}
+
+//----------------------------------------------------------------------
+// SynchList<T>::AppendN
+//      Append "n" items to the end of the list, in order.  Each time
+//	through, as many as fit go on the list under one acquisition of
+//	the lock, and the consumers are woken up once for all of them;
+//	then we wait for room for the rest.  Other producers' items may
+//	end up between two such runs.
+//
+//	"items" is an array of the "n" things to put on the list.
+//
+// Returns:
+//	"n".
+//----------------------------------------------------------------------
+
+template <class T>
+int SynchList<T>::AppendN(T *items, int n)
+{
+    int done = 0;
+
+    lock->Acquire();
+    while (done < n)
+    {
+        while (IsFull())
+            listFull->Wait(lock);
+
+        int before = done;
+        while (done < n && !IsFull())
+            list->Append(items[done++]);
+        if (done - before == 1)
+            listEmpty->Signal(lock);
+        else
+            listEmpty->Broadcast(lock); // enough for several consumers
+    }
+    lock->Release();
+    return n;
+}
+
 //----------------------------------------------------------------------
 // SynchList<T>::RemoveFront
 //      Remove an "item" from the beginning of the list.  Wait if
@@ -74,10 +146,73 @@ T SynchList<T>::RemoveFront()
     while (list->IsEmpty())
         listEmpty->Wait(lock); // wait until list isn't empty
     item = list->RemoveFront();
+    if (capacity != 0)
+        listFull->Signal(lock); // there is room for one more
     lock->Release();
     return item;
 }
 
+//----------------------------------------------------------------------
+// SynchList<T>::TryRemoveFront
+//      Remove an item from the beginning of the list into "*item",
+//	unless the list is empty.  Never waits.
+//
+// Returns:
+//	TRUE if an item was removed.
+//----------------------------------------------------------------------
+
+template <class T>
+bool SynchList<T>::TryRemoveFront(T *item)
+{
+    bool removed = FALSE;
+
+    lock->Acquire();
+    if (!list->IsEmpty())
+    {
+        *item = list->RemoveFront();
+        if (capacity != 0)
+            listFull->Signal(lock);
+        removed = TRUE;
+    }
+    lock->Release();
+    return removed;
+}
+
+//----------------------------------------------------------------------
+// SynchList<T>::RemoveUpTo
+//      Remove up to "max" items from the beginning of the list, under
+//	one acquisition of the lock.  Wait if the list is empty, but
+//	once there is something, take what there is rather than wait
+//	for "max" items.
+//
+//	"items" is an array of room for "max" things.
+//
+// Returns:
+//	The number of items removed, at least 1.
+//----------------------------------------------------------------------
+
+template <class T>
+int SynchList<T>::RemoveUpTo(T *items, int max)
+{
+    int n = 0;
+
+    ASSERT(max > 0);
+    lock->Acquire();
+    while (list->IsEmpty())
+        listEmpty->Wait(lock);
+    while (n < max && !list->IsEmpty())
+        items[n++] = list->RemoveFront();
+    if (capacity != 0)
+    {
+        if (n == 1)
+            listFull->Signal(lock);
+        else
+            listFull->Broadcast(lock);
+    }
+    lock->Release();
+    return n;
+}
+
 //----------------------------------------------------------------------
 // SynchList<T>::Apply
 //      Apply function to every item on a list.
@@ -131,5 +266,7 @@ void SynchList<T>::RemoveSpecificOne(T i)
 {
     lock->Acquire();
     list->Remove(i);
+    if (capacity != 0)
+        listFull->Signal(lock);
     lock->Release();
 }
\ No newline at end of file
@@ -19,17 +19,37 @@
 //	1. Threads trying to remove an item from a list will
 //	wait until the list has an element on it.
 //	2. One thread at a time can access list data structures
+//	3. If the list has a capacity, threads trying to add an item
+//	to a full list will wait until there is room for it, so a
+//	fast producer cannot make the list grow without bound.
+//
+// AppendN and RemoveUpTo move a batch of items at a time, paying for
+// the lock and the wakeups once per batch instead of once per item.
 
 template <class T>
 class SynchList {
   public:
-    SynchList();		// initialize a synchronized list
+    SynchList(int capacity = 0);
+				// initialize a synchronized list, holding
+				// at most "capacity" items (0: no limit)
     ~SynchList();		// de-allocate a synchronized list
 
     void Append(T item);	// append item to the end of the list,
-				// and wake up any thread waiting in remove
+				// waiting if the list is full, and wake
+				// up any thread waiting in remove
+    bool TryAppend(T item);	// append item if the list isn't full;
+				// FALSE if it is
+    int AppendN(T *items, int n);
+				// append n items, waiting for room as
+				// needed; returns n
 
     T RemoveFront();		// remove the first item from the front of the list, waiting if the list is empty
+    bool TryRemoveFront(T *item);
+				// remove the first item if there is one;
+				// FALSE if the list is empty
+    int RemoveUpTo(T *items, int max);
+				// remove between 1 and max items, waiting
+				// if the list is empty; returns how many
     void RemoveSpecificOne(T i);
 
     void Apply(void (*f)(T)); // apply function to all elements in list
@@ -40,6 +60,11 @@ class SynchList {
     List<T> *list;		// the list of things
     Lock *lock;			// enforce mutual exclusive access to the list
     Condition *listEmpty;	// wait in Remove if the list is empty
+    Condition *listFull;	// wait in Append if the list is full
+    int capacity;		// most items the list may hold, 0 if
+				// unbounded
+
+    bool IsFull() { return capacity != 0 && (int)list->NumInList() >= capacity; }
     
     // these are only to assist SelfTest()
     SynchList<T> *selfTestPing;
@@ -20,6 +20,9 @@
 #include "thread.h"
 #include "switch.h"
 #include "synch.h"
+#include "threadstats.h"
+#include "threadcache.h"
+#include "threadtable.h"
 #include "sysdep.h"
 #include <unistd.h>
 #include <sys/types.h>
@@ -27,6 +30,8 @@
 // this is put at the top of the execution stack, for detecting stack overflows
 const int STACK_FENCEPOST = 0xdedbeef;
 
+#define MY_TEST_THREAD_NUM 1000
+
 //----------------------------------------------------------------------
 // Thread::Thread
 // 	Initialize a thread control block, so that we can then call
@@ -36,25 +41,33 @@ const int STACK_FENCEPOST = 0xdedbeef;
 //----------------------------------------------------------------------
 
 Thread::Thread(char *threadName)
+    : queueLink(this), blockLink(this), heldLocks(&Lock::heldLink)
 {
-    threadID = addAThread(this);
-    ASSERT(threadID!=-1);
+    threadID = kernel->threadTable->Add(this);
     if(typeno==1)
     {
-        priority = 8;
+        priority = basePriority = 8;
         timeSliceRemain = timeSlice;
     }
     else if(typeno==3) priority = -1;
     userID = (int)getuid();
+    waitingFor = NULL;
+    rtPeriod = rtBudget = rtDeadline = 0;
+    rtRelease = rtAbsDeadline = rtBudgetRemain = rtLastCharged = 0;
     name = threadName;
     stackTop = NULL;
     stack = NULL;
     status = JUST_CREATED;
+    schedStats = new ThreadStats(threadID, threadName, kernel->stats->totalTicks);
     for (int i = 0; i < MachineStateSize; i++)
     {
         machineState[i] = NULL; // not strictly necessary, since new thread ignores contents of machine registers
     }
     space = NULL;
+    userStackSlot = 0;
+    resumeImage = NULL;
+    resumeSlot = NULL;
+    resumePending = 0;
 }
 
 //----------------------------------------------------------------------
@@ -74,10 +87,53 @@ Thread::~Thread()
     DEBUG(dbgThread, "Deleting thread: " << name);
 
     ASSERT(this != kernel->currentThread);
-    if(this->space!=NULL) delete this->space;
+    if(this->space!=NULL && this->space->RemoveThread()) delete this->space;
+    DropResumeImage();
     if (stack != NULL)
-        DeallocBoundedArray((char *)stack, StackSize * sizeof(int));
-    removeAThread(this->getTID());
+        kernel->threadCache->FreeStack(stack);
+    kernel->threadTable->Remove(this->getTID());
+    kernel->RetireThreadStats(schedStats);
+}
+
+//----------------------------------------------------------------------
+// Thread::operator new, operator delete
+// 	Recycle the memory of deleted threads, see threadcache.h.
+//----------------------------------------------------------------------
+
+void *Thread::operator new(size_t size)
+{
+    ASSERT(size == sizeof(Thread));
+    return kernel->threadCache->AllocThread();
+}
+
+void Thread::operator delete(void *block)
+{
+    kernel->threadCache->FreeThread(block);
+}
+
+//----------------------------------------------------------------------
+// Thread::setStatus
+// 	Change the state of the thread, charging the time spent in the
+//	old state to the thread's accounting record.
+//----------------------------------------------------------------------
+
+void Thread::setStatus(ThreadStatus st)
+{
+    schedStats->Transition(status, st, kernel->stats->totalTicks);
+    status = st;
+}
+
+//----------------------------------------------------------------------
+// Thread::Print
+// 	One line of Kernel::TS: identity, state, and where the time went.
+//----------------------------------------------------------------------
+
+void Thread::Print()
+{
+    cerr << getTID() << "\t" << getName() << "\t" << getTUID() << "\t"
+         << threadStatusName[getStatus()] << "\t" << getPriority() << "\t";
+    schedStats->Print();
+    cerr << endl;
 }
 
 //----------------------------------------------------------------------
@@ -113,7 +169,7 @@ void Thread::Fork(VoidFunctionPtr func, void *arg)
     oldLevel = interrupt->SetLevel(IntOff);
     scheduler->ReadyToRun(this); // ReadyToRun assumes that interrupts are disabled!
     (void)interrupt->SetLevel(oldLevel);
-    if(typeno==1 && kernel->scheduler->getReadyListFront()->getPriority()<kernel->currentThread->getPriority()) kernel->currentThread->Yield();
+    if(kernel->scheduler->ShouldPreempt()) kernel->currentThread->Yield();
 }
 
 //----------------------------------------------------------------------
@@ -185,6 +241,8 @@ void Thread::Finish()
 
     DEBUG(dbgThread, "Finishing thread: " << name);
 
+    if (IsRealTime())
+        kernel->scheduler->RetireRealTime(this);
     Sleep(TRUE); // invokes SWITCH
     // not reached
 }
@@ -256,7 +314,11 @@ void Thread::Sleep(bool finishing)
 
     DEBUG(dbgThread, "Sleeping thread: " << name);
 
-    kernel->scheduler->blockAThread(this);
+    if (finishing)
+        setStatus(BLOCKED);	// about to be deleted; keep it off
+                                // the block list
+    else
+        kernel->scheduler->blockAThread(this);
     while ((nextThread = kernel->scheduler->FindNextToRun()) == NULL)
         kernel->interrupt->Idle(); // no one to run, wait for an interrupt
 
@@ -264,6 +326,71 @@ void Thread::Sleep(bool finishing)
     kernel->scheduler->Run(nextThread, finishing);
 }
 
+//----------------------------------------------------------------------
+// Thread::SetRealTime
+// 	Put this thread in the earliest-deadline-first real-time class.
+//	Must be called before Fork.  The first job is released now.
+//
+//	Returns FALSE, and leaves the thread in the normal class, if
+//	admission control rejects it.
+//
+//	"period" is the time between job releases, in ticks.
+//	"budget" is the CPU time each job may use, in ticks.
+//	"deadline" is the deadline of each job, relative to its release.
+//----------------------------------------------------------------------
+
+bool Thread::SetRealTime(int period, int budget, int deadline)
+{
+    ASSERT(status == JUST_CREATED);
+    ASSERT(period > 0 && budget > 0 && budget <= deadline);
+
+    IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+    bool admitted = kernel->scheduler->AdmitRealTime(period, budget, deadline);
+    if (admitted)
+    {
+        rtPeriod = period;
+        rtBudget = budget;
+        rtDeadline = deadline;
+        ReleaseJob(kernel->stats->totalTicks);
+    }
+    (void)kernel->interrupt->SetLevel(oldLevel);
+    return admitted;
+}
+
+//----------------------------------------------------------------------
+// Thread::ReleaseJob
+// 	Start a new job of this real-time thread, with a full budget.
+//
+//	"when" is the release time of the job.
+//----------------------------------------------------------------------
+
+void Thread::ReleaseJob(int when)
+{
+    rtRelease = when;
+    rtAbsDeadline = when + rtDeadline;
+    rtBudgetRemain = rtBudget;
+    kernel->stats->numRealTimeJobs++;
+}
+
+//----------------------------------------------------------------------
+// Thread::WaitForNextPeriod
+// 	Called by a real-time thread when its current job is done.
+//	Sleeps until the next job is released, unless that has already
+//	happened.
+//----------------------------------------------------------------------
+
+void Thread::WaitForNextPeriod()
+{
+    IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+
+    ASSERT(this == kernel->currentThread);
+    ASSERT(IsRealTime());
+
+    if (kernel->scheduler->RealTimeJobDone(this))
+        Sleep(FALSE);
+    (void)kernel->interrupt->SetLevel(oldLevel);
+}
+
 //----------------------------------------------------------------------
 // ThreadBegin, ThreadFinish,  ThreadPrint
 //	Dummy functions because C++ does not (easily) allow pointers to member
@@ -274,59 +401,90 @@ void Thread::Sleep(bool finishing)
 
 static void ThreadFinish() { kernel->currentThread->Finish(); }
 static void ThreadBegin() { kernel->currentThread->Begin(); }
+
+//----------------------------------------------------------------------
+// Thread::SaveAThread
+// 	Write the resident pages of a suspended thread to "fname" and
+//	give their frames back.  Pages of an earlier image that were
+//	never paged in (see "-lr") go into the new image too.
+//
+//	The image is built in memory and written with a single WriteAt;
+//	its layout is described by SuspendHeader in thread.h.
+//
+//	The thread must be the only one using its address space (see
+//	Scheduler::suspendAThread).
+//----------------------------------------------------------------------
+
 void Thread::SaveAThread(char* fname)
 {
+    ASSERT(this->space->NumThreads() == 1);
     OpenFile* f = NULL;
 #ifdef FILESYS_STUB
     f = kernel->fileSystem->Open(fname);
 #endif
     ASSERT(f != NULL);
     Machine* m = kernel->machine;
-    int pageNum = 0, offset = sizeof(int);
+    int numVPages = this->space->getNumPages();
+    int *frameOf = new int[numVPages];	// resident frame of each page, or -1
+    int pageNum = 0;
+
+    for(int i=0;i<numVPages;++i) frameOf[i] = -1;
 #ifdef USE_RPT
     for(int i=0;i<NumPhysPages;++i)
-        if(m->pt[i].tID == this->getTID() && m->pt[i].valid) ++pageNum;
-    char buf[100];
-    sprintf(buf,"%d",pageNum);
-    ASSERT(f->WriteAt(buf, sizeof(int), 0)>0);
-    for(int i=0;i<NumPhysPages;++i)
-    {
-        if(m->pt[i].tID == this->getTID() && m->pt[i].valid)
-        {
-            m->pt[i].valid = false;
-            m->mmBitmap->Clear(i);
-            sprintf(buf,"%d",m->pt[i].vpn);
-            ASSERT(f->WriteAt(buf, sizeof(int), offset)>0);
-            offset += sizeof(int);
-            ASSERT(f->WriteAt(&(m->mainMemory[i*PageSize]), PageSize, offset)>0);
-            offset += PageSize;
-        }
-    }
+        if(m->pt[i].tID == this->space->getSpaceID() && m->pt[i].valid) frameOf[m->pt[i].vpn] = i;
 #else
     TranslationEntry* pt = this->space->getPT();
-    for(int i=0;i<this->space->getNumPages();++i)
-        if(pt[i].valid) ++pageNum;
-    char buf[100];
-    sprintf(buf,"%d",pageNum);
-    ASSERT(f->WriteAt(buf, sizeof(int), 0)>0);
-    for(int i=0;i<this->space->getNumPages();++i)
+    for(int i=0;i<numVPages;++i)
+        if(pt[i].valid) frameOf[i] = pt[i].ppn;
+#endif
+    for(int i=0;i<numVPages;++i)
+        if(frameOf[i] != -1 || (resumeSlot != NULL && resumeSlot[i] != -1)) ++pageNum;
+
+    int size = sizeof(SuspendHeader) + pageNum * (sizeof(int) + PageSize);
+    char *image = new char[size];
+    SuspendHeader *header = (SuspendHeader *)image;
+    int *index = (int *)(image + sizeof(SuspendHeader));
+    char *payload = (char *)(index + pageNum);
+    int slot = 0;
+
+    header->magic = SuspendMagic;
+    header->numPages = pageNum;
+    if(debug->IsEnabled('a')) m->mmBitmap->Print();
+    for(int i=0;i<numVPages;++i)
     {
-        if(pt[i].valid)
+        if(frameOf[i] != -1)
         {
+            memcpy(payload + slot * PageSize, &(m->mainMemory[frameOf[i] * PageSize]), PageSize);
+#ifdef USE_RPT
+            m->pt[frameOf[i]].valid = false;
+#else
             pt[i].valid = false;
-            if(debug->IsEnabled('a')) m->mmBitmap->Print();
-            m->mmBitmap->Clear(pt[i].ppn);
-            sprintf(buf,"%d",i);
-            ASSERT(f->WriteAt(buf, sizeof(int), offset)>0);
-            offset += sizeof(int);
-            ASSERT(f->WriteAt(&(m->mainMemory[(pt[i].ppn)*PageSize]), PageSize, offset)>0);
-            offset += PageSize;
-            ++pageNum;
+#endif
+            m->mmBitmap->Clear(frameOf[i]);
         }
+        else if(resumeSlot != NULL && resumeSlot[i] != -1)
+            memcpy(payload + slot * PageSize, ResumePayload() + resumeSlot[i] * PageSize, PageSize);
+        else
+            continue;
+        index[slot++] = i;
     }
-#endif
+    int written = f->WriteAt(image, size, 0);
+    ASSERT(written == size);
+
+    DropResumeImage();
+    delete [] image;
+    delete [] frameOf;
     delete f;
 }
+
+//----------------------------------------------------------------------
+// Thread::LoadAThread
+// 	Read back the image written by SaveAThread, with a single
+//	ReadAt.  Every page is put back in memory now, unless "-lr" was
+//	given: then the image is kept, and each page is copied in by
+//	PageInFromImage when the thread first touches it.
+//----------------------------------------------------------------------
+
 void Thread::LoadAThread(char* fname)
 {
     OpenFile* f = NULL;
@@ -334,25 +492,77 @@ void Thread::LoadAThread(char* fname)
     f = kernel->fileSystem->Open(fname);
 #endif
     ASSERT(f != NULL);
-    char buf[100];
-    f->ReadAt(buf, sizeof(int), 0);
-    int numPages = atoi(buf), offset = sizeof(int);    
+    int size = f->Length();
+    char *image = new char[size];
+    ASSERT(size >= (int)sizeof(SuspendHeader));
+    int numRead = f->ReadAt(image, size, 0);
+    ASSERT(numRead == size);
+    delete f;
+
+    SuspendHeader *header = (SuspendHeader *)image;
+    int *index = (int *)(image + sizeof(SuspendHeader));
+    int numVPages = this->space->getNumPages();
+    ASSERT(header->magic == SuspendMagic);
+
+    DropResumeImage();
+    resumeImage = image;
+    resumeSlot = new int[numVPages];
+    for(int i=0;i<numVPages;++i) resumeSlot[i] = -1;
+    for(int i=0;i<header->numPages;++i) resumeSlot[index[i]] = i;
+    resumePending = header->numPages;
+    if(resumePending == 0)
+    {
+        DropResumeImage();
+        return;
+    }
+    if(kernel->lazyResume)
+        return;
+
     Machine* m = kernel->machine;
-    for(int i=0;i<numPages;++i)
+    for(int i=0;i<header->numPages;++i)
     {
-        f->ReadAt(buf, sizeof(int), offset);
-        int vpn = atoi(buf);
-        offset += sizeof(int);
+        int vpn = index[i];
         int avaiPageFrame = m->findAvailablePageFrame();
 		if(avaiPageFrame == -1)
 		{
 			DEBUG(dbgAddr,"No physical page frames in main memory available now !");
 			avaiPageFrame = m->findOneToReplace(m->pt, 0);
 		}
-        this->loadPageFrame(vpn, avaiPageFrame, offset, f);
-        offset += PageSize;
+        this->PageInFromImage(vpn, avaiPageFrame);	// may free the image
     }
-    delete f;
+}
+
+//----------------------------------------------------------------------
+// Thread::PageInFromImage
+// 	If page "vpn" is still waiting in the image LoadAThread read,
+//	copy it into frame "ppn" and return TRUE.  The image is freed
+//	once its last page has been copied in.
+//----------------------------------------------------------------------
+
+bool Thread::PageInFromImage(int vpn, int ppn)
+{
+    if(resumeSlot == NULL || resumeSlot[vpn] == -1)
+        return FALSE;
+    this->mapPageFrame(vpn, ppn);
+    memcpy(&(kernel->machine->mainMemory[ppn*PageSize]), ResumePayload() + resumeSlot[vpn] * PageSize, PageSize);
+    resumeSlot[vpn] = -1;
+    if(--resumePending == 0)
+        DropResumeImage();
+    return TRUE;
+}
+
+char *Thread::ResumePayload()
+{
+    return resumeImage + sizeof(SuspendHeader) + ((SuspendHeader *)resumeImage)->numPages * sizeof(int);
+}
+
+void Thread::DropResumeImage()
+{
+    if(resumeImage != NULL) delete [] resumeImage;
+    if(resumeSlot != NULL) delete [] resumeSlot;
+    resumeImage = NULL;
+    resumeSlot = NULL;
+    resumePending = 0;
 }
 void ThreadPrint(Thread *t) { t->Print(); }
 
@@ -397,7 +607,7 @@ PLabelToAddr(void *plabel)
 
 void Thread::StackAllocate(VoidFunctionPtr func, void *arg)
 {
-    stack = (int *)AllocBoundedArray(StackSize * sizeof(int));
+    stack = kernel->threadCache->AllocStack();
 
 #ifdef PARISC
     // HP stack works from low addresses to high addresses
@@ -437,6 +647,15 @@ void Thread::StackAllocate(VoidFunctionPtr func, void *arg)
     *stack = STACK_FENCEPOST;
 #endif
 
+#ifdef x86_64
+    // as on the x86, SWITCH() returns to ThreadRoot through the stack.
+    // The slot holding that address must be 16-byte aligned, so that
+    // ThreadRoot finds the stack as if it had been called.
+    stackTop = (int *)((unsigned long)(stack + StackSize - 8) & ~15UL);
+    *(void **)stackTop = (void *)ThreadRoot;
+    *stack = STACK_FENCEPOST;
+#endif
+
 #ifdef PARISC
     machineState[PCState] = PLabelToAddr(ThreadRoot);
     machineState[StartupPCState] = PLabelToAddr(ThreadBegin);
@@ -467,6 +686,7 @@ void Thread::SaveUserState()
 {
     for (int i = 0; i < NumTotalRegs; i++)
         userRegisters[i] = kernel->machine->ReadRegister(i);
+    kernel->machine->BreakLink(); // another thread may write the word
 }
 
 //----------------------------------------------------------------------
@@ -583,9 +803,10 @@ void Thread::MyThreadTest()
     
     if(typeno==0)
     {
-        char tname[MaxThreadNum+5][20]={0};
-        Thread* t[MaxThreadNum+5]={0};
-        for(int i=1;;++i)
+        // 线程数已没有上限，创建远多于原来128个的线程
+        char tname[MY_TEST_THREAD_NUM+1][20]={0};
+        Thread* t[MY_TEST_THREAD_NUM+1]={0};
+        for(int i=1;i<=MY_TEST_THREAD_NUM;++i)
         {
             sprintf(tname[i],"线程%d",i);
             t[i] = new Thread(tname[i]);
@@ -603,29 +824,18 @@ void Thread::MyThreadTest()
     }
 }
 
-int Thread::addAThread(Thread* t)
-{
-    for(int i=0;i<MaxThreadNum;++i)
-    {
-        if(!kernel->threadArray[i])
-        {
-            kernel->threadArray[i] = t;
-            return i;
-        }
-    }
-    return -1;
-}
-
-void Thread::removeAThread(int tid)
+void Thread::loadPageFrame(int vpn, int ppn, int fileAddr, OpenFile* f)
 {
-    kernel->threadArray[tid] = NULL;
+    this->mapPageFrame(vpn, ppn);
+    if(debug->IsEnabled('a')) cerr<<"Read addr: "<<fileAddr<<" from the file into addr: "<<ppn*PageSize<<" in the main memory!"<<endl;
+    f->ReadAt(&(kernel->machine->mainMemory[ppn*PageSize]), PageSize, fileAddr);
 }
 
-void Thread::loadPageFrame(int vpn, int ppn, int fileAddr, OpenFile* f)
+void Thread::mapPageFrame(int vpn, int ppn)
 {
 #ifdef USE_RPT
     TranslationEntry* pt = kernel->machine->pt;
-    pt[ppn].tID = this->threadID;
+    pt[ppn].tID = this->space->getSpaceID();
     pt[ppn].vpn = vpn;
     pt[ppn].valid = true;
     pt[ppn].ppn = ppn;
@@ -648,7 +858,5 @@ void Thread::loadPageFrame(int vpn, int ppn, int fileAddr, OpenFile* f)
         delete exec;
     }
 #endif
-    if(debug->IsEnabled('a')) cerr<<"Read addr: "<<fileAddr<<" from the file into addr: "<<ppn*PageSize<<" in the main memory!"<<endl;
-    f->ReadAt(&(kernel->machine->mainMemory[ppn*PageSize]), PageSize, fileAddr);
 }
 
@@ -40,10 +40,14 @@
 #include "copyright.h"
 #include "utility.h"
 #include "sysdep.h"
+#include "ilist.h"
 
 #include "machine.h"
 #include "addrspace.h"
 
+class ThreadStats;
+class Lock;
+
 // CPU register state to be saved on context switch.
 // The x86 needs to save only a few registers,
 // SPARC and MIPS needs to save 10 registers,
@@ -52,9 +56,6 @@
 // For simplicity, I just take the maximum over all architectures.
 #define MachineStateSize 75
 
-//最多同时存在128个线程
-#define MaxThreadNum 128
-
 // Size of the thread's private execution stack.
 // WATCH OUT IF THIS ISN'T BIG ENOUGH!!!!!
 const int StackSize = (8 * 1024); // in words
@@ -69,6 +70,17 @@ enum ThreadStatus
   SUSPENDED
 };
 
+// Layout of the image Thread::SaveAThread writes for a suspended thread:
+// a SuspendHeader, then the vpn of each saved page (numPages ints),
+// then the contents of the pages in the same order.  Host byte order.
+#define SuspendMagic 0x50535553	// "SUSP"
+
+struct SuspendHeader
+{
+  int magic;    // SuspendMagic
+  int numPages; // number of pages in the image
+};
+
 static const char threadStatusName[5][20] = {"JUST_CREATED","RUNNING","READY","BLOCKED","SUSPENDED"};
 
 // The following class defines a "thread control block" -- which
@@ -97,6 +109,10 @@ public:
                            // must not be running when delete
                            // is called
 
+  // Thread objects come from, and go back to, kernel->threadCache
+  void *operator new(size_t size);
+  void operator delete(void *block);
+
   // basic thread operations
 
   void Fork(VoidFunctionPtr func, void *arg);
@@ -107,22 +123,42 @@ public:
   void Finish();              // The thread is done executing
 
   void CheckOverflow(); // Check if thread stack has overflowed
-  void setStatus(ThreadStatus st) { status = st; }
+  void setStatus(ThreadStatus st); // also does the per-thread accounting
   ThreadStatus getStatus() { return this->status; }
   char *getName() { return (name); }
-  void removeAThread(int tid);
-  int addAThread(Thread* t);
   int getPriority(){ return priority; }
-  void setPriority(int priority) { this->priority = priority; }
+  void setPriority(int priority) { this->priority = basePriority = priority; }
+  int getBasePriority() { return basePriority; }
+  void inheritPriority(int priority) { this->priority = priority; }
+  // priority donated through a Lock; only Scheduler::ChangePriority
+  // should call this
   int getTID() { return this->threadID; }
   int getTUID() { return this->userID; }
   int getRemainTime() { return this->timeSliceRemain; }
   void setRemainTime(int timeSliceRemain) { this->timeSliceRemain = timeSliceRemain; }
+  // real-time (EDF) scheduling class; all times are in simulated ticks
+  bool SetRealTime(int period, int budget, int deadline);
+  // admit as a periodic real-time thread; must be called before Fork
+  void WaitForNextPeriod();   // current job is done, sleep until the next release
+  bool IsRealTime() { return rtPeriod > 0; }
+  int getPeriod() { return rtPeriod; }
+  int getBudget() { return rtBudget; }
+  int getRelativeDeadline() { return rtDeadline; }
+  int getDeadline() { return rtAbsDeadline; }
+  int getRelease() { return rtRelease; }
+  int getBudgetRemain() { return rtBudgetRemain; }
+  void setBudgetRemain(int budgetRemain) { rtBudgetRemain = budgetRemain; }
+  int getLastCharged() { return rtLastCharged; }
+  void setLastCharged(int when) { rtLastCharged = when; }
+  void ReleaseJob(int when);  // start the job released at "when"
   void SaveAThread(char* fname);
   void LoadAThread(char* fname);
   void loadPageFrame(int vpn, int ppn, int fileAddr, OpenFile* f);
+  bool PageInFromImage(int vpn, int ppn); // lazy page-in after LoadAThread
 
-  void Print() { cerr<<getTID()<<"\t"<<getName()<<"\t"<<getTUID()<<"\t"<<threadStatusName[getStatus()]<<"\t"<<getPriority()<<endl; }
+  ThreadStats *getSchedStats() { return schedStats; }
+
+  void Print();
   void SelfTest(); // test whether thread impl is working
   void MyThreadTest();
 
@@ -138,8 +174,28 @@ private:
   int userID;           //线程所属的用户ID
   int threadID;         //线程ID
   int priority;         //优先级
+  int basePriority;     // priority before any donation (see Lock)
   int timeSliceRemain;  //剩余时间片大小,以时钟中断为单位
 
+  int rtPeriod;         // real-time period, 0 if not a real-time thread
+  int rtBudget;         // execution budget per period
+  int rtDeadline;       // deadline, relative to the release time
+  int rtRelease;        // release time of the current job
+  int rtAbsDeadline;    // absolute deadline of the current job
+  int rtBudgetRemain;   // budget left for the current job
+  int rtLastCharged;    // when the budget was last charged
+
+  ThreadStats *schedStats; // where this thread's time went
+
+  char *resumeImage;    // image read by LoadAThread, while some of
+                        // its pages have not been paged in yet
+  int *resumeSlot;      // slot of each vpn in resumeImage, or -1
+  int resumePending;    // pages of resumeImage not paged in yet
+
+  void mapPageFrame(int vpn, int ppn); // point page vpn at frame ppn
+  char *ResumePayload();               // first page of resumeImage
+  void DropResumeImage();
+
   void StackAllocate(VoidFunctionPtr func, void *arg);
   // Allocate a stack for thread.
   // Used internally by Fork()
@@ -154,6 +210,15 @@ public:
   void RestoreUserState(); // restore user-level register state
 
   AddrSpace *space; // User code this thread is running.
+  int userStackSlot; // which of space's stacks this thread uses
+
+  ListLink<Thread> queueLink; // on a ready queue, or waiting on a
+                              // semaphore or the EDF release list
+  ListLink<Thread> blockLink; // on the scheduler's block or suspend list
+
+  // priority inheritance (typeno 1), see Lock::Acquire
+  IntrusiveList<Lock> heldLocks; // locks this thread holds
+  Lock *waitingFor;              // lock this thread waits for, or NULL
   
 };
 
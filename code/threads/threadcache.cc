@@ -0,0 +1,112 @@
+// threadcache.cc
+//	Routines to recycle thread control blocks and stacks.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "threadcache.h"
+#include "main.h"
+#include "sysdep.h"
+
+//----------------------------------------------------------------------
+// ThreadCache::ThreadCache
+// 	Start with both caches empty.
+//----------------------------------------------------------------------
+
+ThreadCache::ThreadCache(int threadSize, int stackSize)
+{
+    this->threadSize = threadSize;
+    this->stackSize = stackSize;
+    freeThreads = freeStacks = NULL;
+    numFreeThreads = numFreeStacks = 0;
+}
+
+//----------------------------------------------------------------------
+// ThreadCache::~ThreadCache
+// 	Give everything still cached back to the host.
+//----------------------------------------------------------------------
+
+ThreadCache::~ThreadCache()
+{
+    while (freeThreads != NULL)
+    {
+        void *block = freeThreads;
+        freeThreads = *(void **)block;
+        delete[] (char *)block;
+    }
+    while (freeStacks != NULL)
+    {
+        void *block = freeStacks;
+        freeStacks = *(void **)block;
+        DeallocBoundedArray((char *)block, stackSize);
+    }
+}
+
+//----------------------------------------------------------------------
+// ThreadCache::AllocThread, FreeThread
+// 	Get memory for a Thread object, from the cache if possible;
+//	give it back when the thread is deleted.
+//----------------------------------------------------------------------
+
+void *ThreadCache::AllocThread()
+{
+    void *block = freeThreads;
+
+    if (block == NULL)
+    {
+        kernel->stats->numThreadCacheMisses++;
+        return new char[threadSize];
+    }
+    kernel->stats->numThreadCacheHits++;
+    freeThreads = *(void **)block;
+    numFreeThreads--;
+    return block;
+}
+
+void ThreadCache::FreeThread(void *block)
+{
+    if (numFreeThreads == ThreadCacheSize)
+    {
+        delete[] (char *)block;
+        return;
+    }
+    *(void **)block = freeThreads;
+    freeThreads = block;
+    numFreeThreads++;
+}
+
+//----------------------------------------------------------------------
+// ThreadCache::AllocStack, FreeStack
+// 	Same, for the execution stacks.  A stack handed out again still
+//	has its guard pages; Thread::StackAllocate rewrites the fence
+//	post and the initial frame.
+//----------------------------------------------------------------------
+
+int *ThreadCache::AllocStack()
+{
+    void *block = freeStacks;
+
+    if (block == NULL)
+    {
+        kernel->stats->numStackCacheMisses++;
+        return (int *)AllocBoundedArray(stackSize);
+    }
+    kernel->stats->numStackCacheHits++;
+    freeStacks = *(void **)block;
+    numFreeStacks--;
+    return (int *)block;
+}
+
+void ThreadCache::FreeStack(int *stack)
+{
+    if (numFreeStacks == ThreadCacheSize)
+    {
+        DeallocBoundedArray((char *)stack, stackSize);
+        return;
+    }
+    *(void **)stack = freeStacks;
+    freeStacks = stack;
+    numFreeStacks++;
+}
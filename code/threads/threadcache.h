@@ -0,0 +1,47 @@
+// threadcache.h
+//	Data structures to recycle thread control blocks and stacks.
+//
+//	Creating a thread costs a heap allocation for the Thread object
+//	and an mmap for its guarded stack (see AllocBoundedArray), and
+//	deleting it gives both back.  Programs that fork many short-lived
+//	threads spend much of their time there, so Thread::~Thread hands
+//	both to a ThreadCache instead, and the next thread created takes
+//	them from there.
+//
+//	Each cache is a free list threaded through the free blocks
+//	themselves, so it costs no memory of its own.  At most
+//	ThreadCacheSize blocks of each kind are kept; beyond that they
+//	are really freed.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef THREADCACHE_H
+#define THREADCACHE_H
+
+#include "copyright.h"
+
+#define ThreadCacheSize 64
+
+class ThreadCache {
+  public:
+    ThreadCache(int threadSize, int stackSize);
+				// "threadSize", "stackSize" in bytes
+    ~ThreadCache();		// really free everything cached
+
+    void *AllocThread();	// memory for a Thread object
+    void FreeThread(void *block);
+    int *AllocStack();		// a guarded execution stack
+    void FreeStack(int *stack);
+
+  private:
+    int threadSize;
+    int stackSize;
+    void *freeThreads;		// free list of Thread-sized blocks
+    int numFreeThreads;
+    void *freeStacks;		// free list of stacks
+    int numFreeStacks;
+};
+
+#endif // THREADCACHE_H
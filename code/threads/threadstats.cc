@@ -0,0 +1,159 @@
+// threadstats.cc
+//	Routines to account for where each thread's time goes.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "threadstats.h"
+#include "sysdep.h"
+
+//----------------------------------------------------------------------
+// ThreadStats::ThreadStats
+// 	Start accounting for a newly created thread.
+//
+//	"tid", "threadName" identify the thread in the dump.
+//	"now" is the current time, in ticks.
+//----------------------------------------------------------------------
+
+ThreadStats::ThreadStats(int tid, char *threadName, int now)
+{
+    this->tid = tid;
+    strncpy(name, threadName, StatsNameLen - 1);
+    name[StatsNameLen - 1] = '\0';
+    for (int i = 0; i <= SUSPENDED; i++)
+        ticks[i] = 0;
+    for (int i = 0; i < WaitHistSize; i++)
+        waitHist[i] = 0;
+    voluntarySwitches = involuntarySwitches = 0;
+    numWaits = totalWait = maxWait = 0;
+    lastChange = now;
+}
+
+//----------------------------------------------------------------------
+// ThreadStats::Transition
+// 	Charge the time since the last state change to the state being
+//	left.  A thread leaving the ready queue for the CPU also records
+//	how long it waited.
+//----------------------------------------------------------------------
+
+void ThreadStats::Transition(ThreadStatus from, ThreadStatus to, int now)
+{
+    int elapsed = now - lastChange;
+
+    ticks[from] += elapsed;
+    lastChange = now;
+
+    if (from == READY && to == RUNNING)
+    {
+        int bucket = 0;
+        while (bucket < WaitHistSize - 1 && (elapsed >> bucket) != 0)
+            bucket++;
+        waitHist[bucket]++;
+        numWaits++;
+        totalWait += elapsed;
+        if (elapsed > maxWait)
+            maxWait = elapsed;
+    }
+}
+
+//----------------------------------------------------------------------
+// ThreadStats::SwitchedOut
+// 	Count a context switch away from this thread.  As with
+//	getrusage, the switch is voluntary if the thread could not
+//	continue (it blocked or finished) and involuntary if it was
+//	still runnable and went back on the ready queue.
+//----------------------------------------------------------------------
+
+void ThreadStats::SwitchedOut(ThreadStatus status)
+{
+    if (status == READY)
+        involuntarySwitches++;
+    else
+        voluntarySwitches++;
+}
+
+void ThreadStats::Print()
+{
+    cerr << ticks[RUNNING] << "\t" << ticks[READY] << "\t"
+         << ticks[BLOCKED] << "\t" << ticks[SUSPENDED] << "\t"
+         << voluntarySwitches << "/" << involuntarySwitches << "\t"
+         << (numWaits ? totalWait / numWaits : 0) << "/" << maxWait;
+}
+
+//----------------------------------------------------------------------
+// ThreadStats::WriteHeader, Write, WriteTrailer
+// 	Dump the records to the file opened as "fd", one record per
+//	line.  "first" is TRUE for the first record written, which JSON
+//	needs to know about.
+//----------------------------------------------------------------------
+
+void ThreadStats::WriteHeader(int fd, bool json)
+{
+    char buf[200];
+
+    if (json)
+        sprintf(buf, "{\"waitBuckets\": %d, \"threads\": [\n", WaitHistSize);
+    else
+    {
+        strcpy(buf, "tid,name,running,ready,blocked,suspended,"
+                    "voluntary,involuntary,waits,totalWait,maxWait");
+        for (int i = 0; i < WaitHistSize; i++)
+            sprintf(buf + strlen(buf), ",w%d", i);
+        strcat(buf, "\n");
+    }
+    WriteFile(fd, buf, strlen(buf));
+}
+
+void ThreadStats::Write(int fd, bool json, bool first)
+{
+    char buf[600], safeName[2 * StatsNameLen];
+    char *p = safeName;
+
+    // neither format can take the name as is if it has quotes in it
+    for (char *s = name; *s != '\0'; s++)
+    {
+        if (*s == '"' || *s == '\\' || *s == ',')
+        {
+            if (!json)
+                continue;
+            if (*s != ',')
+                *p++ = '\\';
+        }
+        *p++ = *s;
+    }
+    *p = '\0';
+
+    if (json)
+    {
+        sprintf(buf, "%s  {\"tid\": %d, \"name\": \"%s\", \"running\": %d, "
+                     "\"ready\": %d, \"blocked\": %d, \"suspended\": %d, "
+                     "\"voluntary\": %d, \"involuntary\": %d, \"waits\": %d, "
+                     "\"totalWait\": %d, \"maxWait\": %d, \"waitHist\": [",
+                first ? "" : ",\n", tid, safeName, ticks[RUNNING],
+                ticks[READY], ticks[BLOCKED], ticks[SUSPENDED],
+                voluntarySwitches, involuntarySwitches, numWaits,
+                totalWait, maxWait);
+        for (int i = 0; i < WaitHistSize; i++)
+            sprintf(buf + strlen(buf), i ? ", %d" : "%d", waitHist[i]);
+        strcat(buf, "]}");
+    }
+    else
+    {
+        sprintf(buf, "%d,%s,%d,%d,%d,%d,%d,%d,%d,%d,%d", tid, safeName,
+                ticks[RUNNING], ticks[READY], ticks[BLOCKED],
+                ticks[SUSPENDED], voluntarySwitches, involuntarySwitches,
+                numWaits, totalWait, maxWait);
+        for (int i = 0; i < WaitHistSize; i++)
+            sprintf(buf + strlen(buf), ",%d", waitHist[i]);
+        strcat(buf, "\n");
+    }
+    WriteFile(fd, buf, strlen(buf));
+}
+
+void ThreadStats::WriteTrailer(int fd, bool json)
+{
+    if (json)
+        WriteFile(fd, "\n]}\n", 4);
+}
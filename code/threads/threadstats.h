@@ -0,0 +1,61 @@
+// threadstats.h
+//	Per-thread scheduling accounting.
+//
+//	Every thread owns a ThreadStats record.  Thread::setStatus feeds
+//	it each state change, so it knows how many ticks the thread spent
+//	running, ready, blocked and suspended.  Scheduler::Run tells it
+//	about context switches, and every READY -> RUNNING change adds the
+//	time spent on the ready queue to a histogram of scheduling
+//	latency.
+//
+//	When "-ts <file>" is given, the records of finished threads are
+//	kept around, and all records are written out when the machine
+//	halts: as JSON if the file name ends in ".json", else as CSV.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef THREADSTATS_H
+#define THREADSTATS_H
+
+#include "copyright.h"
+#include "thread.h"
+
+// Bucket 0 counts the waits of 0 ticks, bucket i (i > 0) the waits of
+// [2^(i-1), 2^i) ticks; the last bucket also takes everything longer.
+#define WaitHistSize 16
+#define StatsNameLen 32
+
+class ThreadStats {
+  public:
+    ThreadStats(int tid, char *threadName, int now);
+
+    void Transition(ThreadStatus from, ThreadStatus to, int now);
+				// the thread changed state at time "now"
+    void SwitchedOut(ThreadStatus status);
+				// the thread left the CPU; "status" is
+				// what it left it as
+    void Print();		// one line, for Kernel::TS
+
+    static void WriteHeader(int fd, bool json);
+    void Write(int fd, bool json, bool first);
+    static void WriteTrailer(int fd, bool json);
+
+    int tid;
+    char name[StatsNameLen];	// a copy: thread names often live on
+				// the creator's stack
+    int ticks[SUSPENDED + 1];	// ticks spent in each ThreadStatus
+    int voluntarySwitches;	// left the CPU by blocking or finishing
+    int involuntarySwitches;	// left the CPU while still runnable
+				// (time slice, preemption, Yield)
+    int numWaits;		// READY -> RUNNING changes
+    int totalWait;		// ticks spent on the ready queue
+    int maxWait;		// longest single wait
+    int waitHist[WaitHistSize];	// log2 histogram of the waits
+
+  private:
+    int lastChange;		// when the current state was entered
+};
+
+#endif // THREADSTATS_H
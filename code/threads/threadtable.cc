@@ -0,0 +1,97 @@
+// threadtable.cc
+//	Routines to hand out thread IDs and find a thread by ID.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "threadtable.h"
+#include "debug.h"
+
+//----------------------------------------------------------------------
+// ThreadTable::ThreadTable
+// 	Start with an empty table of ThreadTableSize entries.
+//----------------------------------------------------------------------
+
+ThreadTable::ThreadTable()
+{
+    size = ThreadTableSize;
+    table = new Thread *[size];
+    inUse = new unsigned int[size / BitsInWord];
+    for (int i = 0; i < size; i++)
+        table[i] = NULL;
+    for (int i = 0; i < size / BitsInWord; i++)
+        inUse[i] = 0;
+    firstFree = 0;
+}
+
+ThreadTable::~ThreadTable()
+{
+    delete[] table;
+    delete[] inUse;
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::Add
+// 	Give "thread" the lowest free ID, growing the table if there is
+//	none, and return the ID.
+//----------------------------------------------------------------------
+
+int ThreadTable::Add(Thread *thread)
+{
+    int numWords = size / BitsInWord;
+
+    while (firstFree < numWords && inUse[firstFree] == ~0U)
+        firstFree++;
+    if (firstFree == numWords)
+        Grow();
+
+    // the lowest clear bit of the word is the lowest set bit of
+    // its complement
+    int tid = firstFree * BitsInWord + __builtin_ctz(~inUse[firstFree]);
+
+    inUse[firstFree] |= 1U << (tid % BitsInWord);
+    table[tid] = thread;
+    return tid;
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::Remove
+// 	Free the ID of a thread being deleted.
+//----------------------------------------------------------------------
+
+void ThreadTable::Remove(int tid)
+{
+    ASSERT(tid >= 0 && tid < size && table[tid] != NULL);
+
+    table[tid] = NULL;
+    inUse[tid / BitsInWord] &= ~(1U << (tid % BitsInWord));
+    if (tid / BitsInWord < firstFree)
+        firstFree = tid / BitsInWord;
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::Grow
+// 	Double the size of the table.  Only called when every ID is in
+//	use, so the new half is all free.
+//----------------------------------------------------------------------
+
+void ThreadTable::Grow()
+{
+    int newSize = size * 2;
+    Thread **newTable = new Thread *[newSize];
+    unsigned int *newInUse = new unsigned int[newSize / BitsInWord];
+
+    for (int i = 0; i < newSize; i++)
+        newTable[i] = (i < size) ? table[i] : NULL;
+    for (int i = 0; i < newSize / BitsInWord; i++)
+        newInUse[i] = (i < size / BitsInWord) ? inUse[i] : 0;
+    delete[] table;
+    delete[] inUse;
+
+    DEBUG(dbgThread, "Thread table grows to " << newSize << " entries");
+    table = newTable;
+    inUse = newInUse;
+    size = newSize;
+}
@@ -0,0 +1,48 @@
+// threadtable.h
+//	Data structures to hand out thread IDs and find a thread by ID.
+//
+//	A thread ID is an index into a table of Thread pointers.  Which
+//	IDs are in use is kept in a bitmap, so a free ID is found a word
+//	(32 IDs) at a time, starting from the lowest word that may have
+//	a free bit.  Like before, the lowest free ID is always handed
+//	out, so IDs stay small and are reused quickly.
+//
+//	The table starts with ThreadTableSize entries and doubles when
+//	it is full, so there is no limit on the number of threads.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef THREADTABLE_H
+#define THREADTABLE_H
+
+#include "copyright.h"
+#include "bitmap.h"
+
+class Thread;
+
+#define ThreadTableSize 128	// initial size, a multiple of BitsInWord
+
+class ThreadTable {
+  public:
+    ThreadTable();
+    ~ThreadTable();
+
+    int Add(Thread *thread);	// allocate an ID for "thread"
+    void Remove(int tid);	// free the ID
+    Thread *Lookup(int tid) {	// the thread with this ID, or NULL
+	return (tid >= 0 && tid < size) ? table[tid] : NULL; }
+    int Size() { return size; }	// every ID in use is below this
+
+  private:
+    Thread **table;		// thread of each ID, NULL if free
+    unsigned int *inUse;	// bitmap of the IDs in use
+    int size;			// number of entries in "table"
+    int firstFree;		// no word of "inUse" before this one
+				// has a clear bit
+
+    void Grow();		// double the size of the table
+};
+
+#endif // THREADTABLE_H
@@ -0,0 +1,193 @@
+// timingwheel.cc
+//	Routines to manage a hierarchical timing wheel.  See
+//	timingwheel.h for the layout.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "timingwheel.h"
+
+//----------------------------------------------------------------------
+// TimingWheel::TimingWheel
+// 	Initialize an empty wheel, at time 0.
+//----------------------------------------------------------------------
+
+TimingWheel::TimingWheel()
+{
+    for (int level = 0; level < WheelLevels; level++)
+    {
+        for (int i = 0; i < WheelSize; i++)
+            slots[level][i] = NULL;
+        occupied[level] = 0;
+    }
+    current = 0;
+    count = 0;
+}
+
+//----------------------------------------------------------------------
+// TimingWheel::Place
+// 	Link "entry" into the slot for its expiry time: the lowest level
+//	whose span reaches that far.  An entry that is already due goes
+//	into the slot processed next; one beyond the span of the whole
+//	wheel is parked in the last slot of the top level and placed
+//	again when that slot is cascaded.
+//----------------------------------------------------------------------
+
+void TimingWheel::Place(WheelEntry *entry)
+{
+    int delta = (int)(entry->expires - current);
+    unsigned int expires = entry->expires;
+    int level = 0;
+
+    if (delta < 0)
+        expires = current;
+    else
+    {
+        while (level < WheelLevels - 1 && delta >= (1 << (WheelBits * (level + 1))))
+            level++;
+        if (level == WheelLevels - 1 && delta >= (1 << (WheelBits * WheelLevels)))
+            expires = current + (1 << (WheelBits * WheelLevels)) - 1;
+    }
+
+    int index = (expires >> (WheelBits * level)) & WheelMask;
+    entry->next = slots[level][index];
+    slots[level][index] = entry;
+    occupied[level] |= 1ULL << index;
+}
+
+//----------------------------------------------------------------------
+// TimingWheel::Insert
+// 	Add a new entry.  An empty wheel has nothing to catch up on, so
+//	it is first moved forward to the current time.
+//----------------------------------------------------------------------
+
+void TimingWheel::Insert(WheelEntry *entry, int now)
+{
+    if (count == 0)
+        current = now / WheelUnit + 1;
+    Place(entry);
+    count++;
+}
+
+//----------------------------------------------------------------------
+// TimingWheel::Cascade
+// 	The lower levels have gone all the way round: spread the entries
+//	of the next slot of "level" over the levels below it.
+//
+//	Returns TRUE if this level wrapped around as well, so the level
+//	above has to be cascaded too.
+//----------------------------------------------------------------------
+
+bool TimingWheel::Cascade(int level)
+{
+    int index = (current >> (WheelBits * level)) & WheelMask;
+    WheelEntry *entry = slots[level][index];
+
+    slots[level][index] = NULL;
+    occupied[level] &= ~(1ULL << index);
+    while (entry != NULL)
+    {
+        WheelEntry *next = entry->next;
+        Place(entry);
+        entry = next;
+    }
+    return index == 0;
+}
+
+//----------------------------------------------------------------------
+// TimingWheel::Expire
+// 	Process unit "current": cascade the higher levels if level 0 is
+//	about to start a new round, then take out the entries that
+//	expire now.
+//----------------------------------------------------------------------
+
+WheelEntry *TimingWheel::Expire()
+{
+    int index = current & WheelMask;
+    WheelEntry *expired;
+
+    if (index == 0)
+    {
+        for (int level = 1; level < WheelLevels && Cascade(level); level++)
+            ;
+    }
+    expired = slots[0][index];
+    slots[0][index] = NULL;
+    occupied[0] &= ~(1ULL << index);
+    current++;
+    return expired;
+}
+
+//----------------------------------------------------------------------
+// TimingWheel::Advance
+// 	Process every unit up to the one "now" falls in.  Units in which
+//	nothing happens are skipped using the level 0 bitmap, stopping
+//	only where level 0 wraps around and the levels above need a
+//	look.
+//
+//	Returns the expired entries, linked through "next".
+//----------------------------------------------------------------------
+
+WheelEntry *TimingWheel::Advance(int now)
+{
+    unsigned int target = now / WheelUnit;
+    WheelEntry *expired = NULL;
+    WheelEntry **tail = &expired;
+
+    while ((int)(target - current) >= 0)
+    {
+        if (count == 0)
+        {
+            current = target + 1;
+            break;
+        }
+
+        int index = current & WheelMask;
+        if (index != 0)
+        {
+            unsigned long long rest = occupied[0] >> index;
+            int skip = rest ? __builtin_ctzll(rest) : WheelSize - index;
+
+            if ((int)(target - current) < skip)
+            {
+                current = target + 1;
+                break;
+            }
+            current += skip;
+            if (rest == 0)
+                continue;	// at the start of the next round
+        }
+
+        for (WheelEntry *entry = Expire(); entry != NULL; entry = entry->next)
+        {
+            *tail = entry;
+            tail = &entry->next;
+            count--;
+        }
+    }
+    *tail = NULL;
+    return expired;
+}
+
+//----------------------------------------------------------------------
+// TimingWheel::NextExpiry
+// 	Return the time of the next unit Advance has to look at: the
+//	next occupied level 0 slot, or the end of the current round of
+//	level 0, whichever comes first.  Entries on the higher levels
+//	are at least that far away.
+//----------------------------------------------------------------------
+
+int TimingWheel::NextExpiry()
+{
+    int index = current & WheelMask;
+    unsigned int unit = current;
+
+    if (index != 0)
+    {
+        unsigned long long rest = occupied[0] >> index;
+        unit += rest ? __builtin_ctzll(rest) : WheelSize - index;
+    }
+    return unit * WheelUnit;
+}
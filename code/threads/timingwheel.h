@@ -0,0 +1,80 @@
+// timingwheel.h
+//	Data structures for a hierarchical timing wheel, which keeps
+//	track of the threads sleeping in Alarm::WaitUntil.
+//
+//	Time is counted in wheel units of WheelUnit ticks.  The wheel
+//	has WheelLevels levels of WheelSize slots each; slot i of level
+//	L holds the entries expiring in the i-th unit of that level's
+//	current span, so level 0 covers the next WheelSize units, level
+//	1 the next WheelSize^2, and so on.  Inserting an entry is just
+//	linking it into the right slot.  When the level 0 index wraps
+//	around, the next slot of level 1 is "cascaded": its entries are
+//	spread out over level 0 (and likewise for the levels above), so
+//	every entry moves at most WheelLevels times before it expires.
+//
+//	A bitmap per level tells which slots are occupied, so runs of
+//	empty units are skipped instead of stepped through.
+//
+//	The entries belong to the caller (Alarm keeps them on the
+//	sleeping thread's stack), so the wheel never allocates.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef TIMINGWHEEL_H
+#define TIMINGWHEEL_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "stats.h"
+
+class Thread;
+
+#define WheelBits 6
+#define WheelSize (1 << WheelBits)	// slots per level; at most 64,
+					// for the occupancy bitmaps
+#define WheelMask (WheelSize - 1)
+#define WheelLevels 4			// covers 2^24 units
+#define WheelUnit TimerTicks		// ticks per wheel unit
+
+// One sleeping thread.
+
+class WheelEntry {
+  public:
+    Thread *thread;		// who to wake up
+    unsigned int expires;	// wheel unit to wake it up in
+    WheelEntry *next;		// next entry in the same slot
+};
+
+class TimingWheel {
+  public:
+    TimingWheel();
+
+    void Insert(WheelEntry *entry, int now);
+				// add "entry", which expires in wheel
+				// unit entry->expires; "now" is the
+				// current time, in ticks
+    WheelEntry *Advance(int now);
+				// remove and return (linked through
+				// "next") every entry expiring at or
+				// before time "now"
+    int NextExpiry();		// the earliest time, in ticks, at which
+				// Advance has work to do
+    bool IsEmpty() { return count == 0; }
+
+  private:
+    WheelEntry *slots[WheelLevels][WheelSize];
+    unsigned long long occupied[WheelLevels];
+				// bit i set if slots[level][i] isn't empty
+    unsigned int current;	// the next unit to be processed
+    int count;			// number of entries in the wheel
+
+    void Place(WheelEntry *entry);
+				// link "entry" into its slot
+    bool Cascade(int level);	// move the slot of "level" that is due
+				// down; TRUE if the level wrapped too
+    WheelEntry *Expire();	// process unit "current"
+};
+
+#endif // TIMINGWHEEL_H
@@ -20,6 +20,8 @@
 #include "addrspace.h"
 #include "machine.h"
 #include "noff.h"
+#include "synch.h"
+#include "threadtable.h"
 
 //----------------------------------------------------------------------
 // SwapHeader
@@ -76,6 +78,8 @@ AddrSpace::AddrSpace()
 
     // zero out the entire address space
     // bzero(kernel->machine->mainMemory, MemorySize);
+    pt = NULL;
+    InitThreads();
 }
 
 AddrSpace::AddrSpace(char* fileName)
@@ -84,6 +88,7 @@ AddrSpace::AddrSpace(char* fileName)
     NoffHeader noffH;
     int size;
 
+    InitThreads();
     if (executable == NULL)
     {
         cerr << "Unable to open file " << fileName << "\n";
@@ -98,11 +103,11 @@ AddrSpace::AddrSpace(char* fileName)
 
 #ifdef RDATA
     // how big is address space?
-    size = noffH.code.size + noffH.readonlyData.size + noffH.initData.size + noffH.uninitData.size + UserStackSize; //we need to increase the size to leave room for the stack
+    size = noffH.code.size + noffH.readonlyData.size + noffH.initData.size + noffH.uninitData.size + UserThreadNum * UserStackSize; //we need to increase the size to leave room for the stack
     // cerr<<"readOnly data segment start addr:"<<noffH.readonlyData.inFileAddr<<",VA:"<<noffH.readonlyData.virtualAddr<<",size:"<<noffH.readonlyData.size<<";"<<endl;
 #else
     // how big is address space?
-    size = noffH.code.size + noffH.initData.size + noffH.uninitData.size + UserStackSize; // we need to increase the size
+    size = noffH.code.size + noffH.initData.size + noffH.uninitData.size + UserThreadNum * UserStackSize; // we need to increase the size
                                                                                           // to leave room for the stack
 #endif
     // cerr<<"initData segment start addr:"<<noffH.initData.inFileAddr<<",VA:"<<noffH.initData.virtualAddr<<",size:"<<noffH.initData.size<<";\nuninitData segment start addr:"<<noffH.uninitData.inFileAddr<<",VA:"<<noffH.uninitData.virtualAddr<<",size:"<<noffH.uninitData.size<<endl;
@@ -139,6 +144,30 @@ AddrSpace::~AddrSpace()
 {
     // cout<<"什么鬼!"<<endl;
     if(pt != NULL) delete pt;
+    while (!joinRecords->IsEmpty())
+        delete joinRecords->RemoveFront();
+    delete joinRecords;
+    delete threadExited;
+    delete joinLock;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::InitThreads
+// 	Set up the bookkeeping for the threads sharing this space.  The
+//	thread creating the space owns stack slot 0; it is counted when
+//	it calls Execute.
+//----------------------------------------------------------------------
+
+void AddrSpace::InitThreads()
+{
+    static int nextSpaceID = 0;
+
+    spaceID = nextSpaceID++;
+    numThreads = 0;
+    stackSlots = 1;
+    joinLock = new Lock("join lock");
+    threadExited = new Condition("thread exited");
+    joinRecords = new List<ThreadExitRecord *>;
 }
 
 //----------------------------------------------------------------------
@@ -170,10 +199,10 @@ bool AddrSpace::Load(char *fileName)
 
 #ifdef RDATA
     // how big is address space?
-    size = noffH.code.size + noffH.readonlyData.size + noffH.initData.size + noffH.uninitData.size + UserStackSize; //we need to increase the size to leave room for the stack
+    size = noffH.code.size + noffH.readonlyData.size + noffH.initData.size + noffH.uninitData.size + UserThreadNum * UserStackSize; //we need to increase the size to leave room for the stack
 #else
     // how big is address space?
-    size = noffH.code.size + noffH.initData.size + noffH.uninitData.size + UserStackSize; // we need to increase the size
+    size = noffH.code.size + noffH.initData.size + noffH.uninitData.size + UserThreadNum * UserStackSize; // we need to increase the size
                                                                                           // to leave room for the stack
 #endif
     numPages = divRoundUp(size, PageSize);
@@ -225,6 +254,7 @@ bool AddrSpace::Load(char *fileName)
 void AddrSpace::Execute()
 {
     kernel->currentThread->space = this;
+    AddThread(kernel->currentThread->getTID());
 
     this->InitRegisters(); // set the initial register values
     this->RestoreState();  // load page table register
@@ -264,8 +294,184 @@ void AddrSpace::InitRegisters()
     // Set the stack register to the end of the address space, where we
     // allocated the stack; but subtract off a bit, to make sure we don't
     // accidentally reference off the end!
-    machine->WriteRegister(StackReg, numPages * PageSize - 16);
-    DEBUG(dbgAddr, "Initializing stack pointer: " << numPages * PageSize - 16);
+    machine->WriteRegister(StackReg, UserStackTop(0));
+    DEBUG(dbgAddr, "Initializing stack pointer: " << UserStackTop(0));
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::ExecuteThread
+// 	Run a thread forked with ThreadFork: start at "func" on the stack
+//	of "slot", in the current thread, which already points at this
+//	address space.
+//
+//	The forked procedure must end with ThreadExit; there is nowhere
+//	for it to return to.
+//----------------------------------------------------------------------
+
+void AddrSpace::ExecuteThread(int func, int slot)
+{
+    Machine *machine = kernel->machine;
+
+    ASSERT(kernel->currentThread->space == this);
+    for (int i = 0; i < NumTotalRegs; i++)
+        machine->WriteRegister(i, 0);
+    machine->WriteRegister(PCReg, func);
+    machine->WriteRegister(NextPCReg, func + 4);
+    machine->WriteRegister(StackReg, UserStackTop(slot));
+    DEBUG(dbgAddr, "Starting user thread at " << func << ", stack " << UserStackTop(slot));
+
+    this->RestoreState();
+    machine->Run();
+    ASSERTNOTREACHED();
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::AllocUserStack, FreeUserStack, UserStackTop
+// 	The stacks live at the top of the address space, slot 0 at the
+//	very end and slot i UserStackSize * i bytes below it.
+//----------------------------------------------------------------------
+
+int AddrSpace::AllocUserStack()
+{
+    for (int i = 0; i < UserThreadNum; i++)
+    {
+        if (!(stackSlots & (1U << i)))
+        {
+            stackSlots |= 1U << i;
+            return i;
+        }
+    }
+    return -1;
+}
+
+void AddrSpace::FreeUserStack(int slot)
+{
+    ASSERT(slot >= 0 && slot < UserThreadNum);
+    stackSlots &= ~(1U << slot);
+}
+
+int AddrSpace::UserStackTop(int slot)
+{
+    // subtract off a bit, to make sure we don't accidentally reference
+    // off the end!
+    return numPages * PageSize - slot * UserStackSize - 16;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::FindRecord, DropRecord
+// 	The join records of the space.  A record whose ID has been
+//	given to another thread is dropped as soon as no ThreadJoin
+//	caller holds it.  The caller must hold joinLock.
+//----------------------------------------------------------------------
+
+ThreadExitRecord *AddrSpace::FindRecord(int tid)
+{
+    ListIterator<ThreadExitRecord *> iter(joinRecords);
+
+    for (; !iter.IsDone(); iter.Next())
+    {
+        if (iter.Item()->tid == tid)
+            return iter.Item();
+    }
+    return NULL;
+}
+
+void AddrSpace::DropRecord(ThreadExitRecord *record)
+{
+    record->tid = -1;
+    if (record->joiners == 0)
+    {
+        joinRecords->Remove(record);
+        delete record;
+    }
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::AddThread
+// 	Thread "tid" starts using the space: count it, and give it a
+//	record for ThreadJoin.
+//
+//	An exited thread whose ID has been given to another thread,
+//	this one or one outside the space, is not joinable any more;
+//	its record goes away here, so the records of threads nobody
+//	joins do not pile up.
+//----------------------------------------------------------------------
+
+void AddrSpace::AddThread(int tid)
+{
+    ThreadExitRecord *record = new ThreadExitRecord;
+    List<ThreadExitRecord *> stale;
+    Thread *t;
+
+    numThreads++;
+    record->tid = tid;
+    record->exited = FALSE;
+    record->status = -1;
+    record->joiners = 0;
+    joinLock->Acquire();
+    ListIterator<ThreadExitRecord *> iter(joinRecords);
+    for (; !iter.IsDone(); iter.Next())
+    {
+        if (!iter.Item()->exited || iter.Item()->tid == -1)
+            continue;
+        t = kernel->threadTable->Lookup(iter.Item()->tid);
+        if (iter.Item()->tid == tid || (t != NULL && t->space != this))
+            stale.Append(iter.Item());
+    }
+    while (!stale.IsEmpty())
+        DropRecord(stale.RemoveFront());
+    joinRecords->Append(record);
+    joinLock->Release();
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::ThreadExited
+// 	Thread "tid" of this space exited with "status"; remember it
+//	until somebody joins it.
+//----------------------------------------------------------------------
+
+void AddrSpace::ThreadExited(int tid, int status)
+{
+    ThreadExitRecord *record;
+
+    joinLock->Acquire();
+    record = FindRecord(tid);
+    ASSERT(record != NULL && !record->exited);
+    record->exited = TRUE;
+    record->status = status;
+    threadExited->Broadcast(joinLock);
+    joinLock->Release();
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::Join
+// 	Wait until thread "tid" of this space exits, and return its exit
+//	status.  Returns -1 right away if there is no such thread (or it
+//	has already been joined), or it is the calling thread.
+//
+//	The record is looked up by ID once; after that we wait on the
+//	record itself, so a new thread getting the ID meanwhile does
+//	not matter.
+//----------------------------------------------------------------------
+
+int AddrSpace::Join(int tid)
+{
+    ThreadExitRecord *record;
+    int status = -1;
+
+    joinLock->Acquire();
+    record = FindRecord(tid);
+    if (record != NULL && tid != kernel->currentThread->getTID())
+    {
+        record->joiners++;
+        while (!record->exited)
+            threadExited->Wait(joinLock);
+        status = record->status;
+        record->joiners--;
+        DropRecord(record);		// a thread is joined only once
+    }
+    joinLock->Release();
+    return status;
 }
 
 //----------------------------------------------------------------------
@@ -16,8 +16,26 @@
 #include "copyright.h"
 #include "filesys.h"
 #include "noff.h"
+#include "list.h"
 
 #define UserStackSize		1024 	// increase this as necessary!
+#define UserThreadNum		8	// most user threads (ThreadFork) that
+					// can share one address space; each
+					// gets its own UserStackSize stack
+
+class Lock;
+class Condition;
+
+// What ThreadJoin waits on: one per thread that has used the space,
+// from when it starts until it is joined, or its thread ID is given
+// to another thread of the space.  A joiner keeps the record itself,
+// so a thread ID being reused cannot make it see the wrong thread.
+struct ThreadExitRecord {
+    int tid;			// -1 once the ID may mean another thread
+    bool exited;
+    int status;			// valid once "exited"
+    int joiners;		// ThreadJoin callers holding the record
+};
 
 class AddrSpace {
   public:
@@ -49,6 +67,26 @@ class AddrSpace {
     void openAFile(OpenFile* f, NoffHeader noffHeader);
     OpenFile* getCurrentOpenFile() { return this->currentOpenedFile; }
     NoffHeader getCurrentNoffHeader() { return this->currentNoffHeader; };
+    int getSpaceID() { return spaceID; }
+
+    // User-level threads sharing this address space, see the
+    // SC_Thread* system calls in exception.cc.  The page table is
+    // shared; each thread has a stack slot of its own, slot 0 being
+    // the stack of the thread that created the space.
+    int AllocUserStack();		// a free stack slot, or -1
+    void FreeUserStack(int slot);
+    void AddThread(int tid);		// thread "tid" starts using the space
+    bool RemoveThread() { return --numThreads == 0; }
+					// a thread is deleted; TRUE if it
+					// was the last one
+    int NumThreads() { return numThreads; }
+    void ExecuteThread(int func, int slot);
+					// run "func" on stack "slot" in the
+					// current thread
+    void ThreadExited(int tid, int status);
+					// wake up ThreadJoin callers
+    int Join(int tid);			// wait for thread "tid" of this space
+					// to exit; its status, or -1
 
   private:
     TranslationEntry *pt;	// Assume linear page table translation for now!
@@ -57,6 +95,23 @@ class AddrSpace {
     OpenFile* currentOpenedFile;
     NoffHeader currentNoffHeader;
 
+    int spaceID;		// tags this space's frames in the inverted
+				// page table (USE_RPT)
+    int numThreads;		// threads using this address space
+    unsigned int stackSlots;	// bitmap of the stack slots in use
+    Lock *joinLock;		// protects joinRecords
+    Condition *threadExited;	// signalled when a thread exits
+    List<ThreadExitRecord *> *joinRecords;
+				// threads of the space nobody has
+				// joined yet, live or exited
+
+    void InitThreads();		// set up the fields above
+    ThreadExitRecord *FindRecord(int tid);
+				// the record of thread "tid", or NULL
+    void DropRecord(ThreadExitRecord *record);
+				// forget "record", now or when the
+				// joiners holding it are done
+    int UserStackTop(int slot);	// initial stack pointer of a slot
     void InitRegisters();		// Initialize user-level CPU registers, before jumping to user code
 };
 
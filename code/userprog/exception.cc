@@ -25,6 +25,81 @@
 #include "main.h"
 #include "syscall.h"
 #include "ksyscall.h"
+
+//----------------------------------------------------------------------
+// AdvancePC
+// 	Move the user program counter past the syscall instruction.
+//----------------------------------------------------------------------
+
+static void AdvancePC()
+{
+	/* set previous programm counter (debugging only)*/
+	kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
+
+	/* set programm counter to next instruction (all Instructions are 4 byte wide)*/
+	kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
+
+	/* set next programm counter for brach execution */
+	kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg) + 4);
+}
+
+//----------------------------------------------------------------------
+// ExitUserThread
+// 	Exit and ThreadExit.  The exit status is handed to ThreadJoin
+//	callers.  The memory of the address space is given back only
+//	when its last thread exits; a program whose main thread calls
+//	Exit keeps running as long as some thread it forked does.
+//----------------------------------------------------------------------
+
+static void ExitUserThread(int status)
+{
+	AddrSpace *space = kernel->currentThread->space;
+	bool lastThread = (space != NULL && space->NumThreads() == 1);
+
+	if(space != NULL)
+	{
+		space->ThreadExited(kernel->currentThread->getTID(), status);
+		space->FreeUserStack(kernel->currentThread->userStackSlot);
+	}
+#ifdef USE_RPT
+	if(lastThread)
+	{
+		for(int i=0;i<NumPhysPages;++i)
+		{
+			if(kernel->machine->pt[i].tID == space->getSpaceID())
+			{
+				kernel->machine->mmBitmap->Clear(i);
+				kernel->machine->pt[i].reset();
+			}
+		}
+		if(kernel->machine->tlb != NULL)
+		{
+			for(int i=0;i<TLBSize;++i)
+			{
+				if(kernel->machine->tlb[i].tID == space->getSpaceID())
+					kernel->machine->tlb[i].reset();
+			}
+		}
+	}
+#else
+	if(lastThread)
+	{
+		kernel->fileSystem->Remove(space->getVMFileName());
+		for(int i=0;i<space->getNumPages();++i)
+		{
+			if(kernel->machine->pt[i].valid)
+				kernel->machine->mmBitmap->Clear(kernel->machine->pt[i].ppn);
+		}
+		if(debug->IsEnabled('a')) kernel->machine->mmBitmap->Print();
+	}
+	if(kernel->machine->tlb != NULL)
+	{
+		for(int i=0;i<TLBSize;++i) kernel->machine->tlb[i].reset();
+	}
+#endif
+	kernel->currentThread->Finish();
+}
+
 //----------------------------------------------------------------------
 // ExceptionHandler
 // 	Entry point into the Nachos kernel.  Called when a user program
@@ -64,43 +139,56 @@ void ExceptionHandler(ExceptionType which)
 			SysHalt();
 			ASSERTNOTREACHED();
 		}
-		else if(type == SC_Exit)
+		else if(type == SC_Exit || type == SC_ThreadExit)
 		{
-			if(debug->IsEnabled('s')) cerr<<"Current thread "<<kernel->currentThread->getName()<<" exit!\n";
-#ifdef USE_RPT
-			for(int i=0;i<NumPhysPages;++i)
-			{
-				if(kernel->machine->pt[i].tID == kernel->currentThread->getTID())
-				{
-					kernel->machine->mmBitmap->Clear(i);
-					kernel->machine->pt[i].reset();
-				}
-			}
-			if(kernel->machine->tlb != NULL)
-			{
-				for(int i=0;i<TLBSize;++i)
-				{
-					if(kernel->machine->tlb[i].tID == kernel->currentThread->getTID())
-						kernel->machine->tlb[i].reset();
-				}
-			}
-#else
-			if(kernel->currentThread->space != NULL)
-			{
-				kernel->fileSystem->Remove(kernel->currentThread->space->getVMFileName());
-				for(int i=0;i<kernel->currentThread->space->getNumPages();++i)
-				{
-					if(kernel->machine->pt[i].valid)
-						kernel->machine->mmBitmap->Clear(kernel->machine->pt[i].ppn);
-				}
-				if(debug->IsEnabled('a')) kernel->machine->mmBitmap->Print();
-			}
-			if(kernel->machine->tlb != NULL)
-			{
-				for(int i=0;i<TLBSize;++i) kernel->machine->tlb[i].reset();
-			}
-#endif
-			kernel->currentThread->Finish();
+			if(debug->IsEnabled('s')) cerr<<"Current thread "<<kernel->currentThread->getName()<<" exit with status "<<(int)kernel->machine->ReadRegister(4)<<"!\n";
+			ExitUserThread((int)kernel->machine->ReadRegister(4));
+			ASSERTNOTREACHED();
+		}
+		else if(type == SC_ThreadFork)
+		{
+			int tid = SysThreadFork((int)kernel->machine->ReadRegister(4));
+			DEBUG(dbgSys, "ThreadFork returning with " << tid << "\n");
+			kernel->machine->WriteRegister(2, tid);
+			AdvancePC();
+			return;
+		}
+		else if(type == SC_ThreadYield)
+		{
+			SysThreadYield();
+			AdvancePC();
+			return;
+		}
+		else if(type == SC_ThreadJoin)
+		{
+			int status = SysThreadJoin((int)kernel->machine->ReadRegister(4));
+			DEBUG(dbgSys, "ThreadJoin returning with " << status << "\n");
+			kernel->machine->WriteRegister(2, status);
+			AdvancePC();
+			return;
+		}
+		else if(type == SC_FutexWait)
+		{
+			int result = SysFutexWait((int)kernel->machine->ReadRegister(4),
+						  (int)kernel->machine->ReadRegister(5));
+			DEBUG(dbgSys, "FutexWait returning with " << result << "\n");
+			kernel->machine->WriteRegister(2, result);
+			AdvancePC();
+			return;
+		}
+		else if(type == SC_FutexWake)
+		{
+			int woken = SysFutexWake((int)kernel->machine->ReadRegister(4),
+						 (int)kernel->machine->ReadRegister(5));
+			DEBUG(dbgSys, "FutexWake woke " << woken << "\n");
+			kernel->machine->WriteRegister(2, woken);
+			AdvancePC();
+			return;
+		}
+		else if(type == SC_Clock)
+		{
+			kernel->machine->WriteRegister(2, (int)SysClock());
+			AdvancePC();
 			return;
 		}
 		else if(type == SC_Add)
@@ -154,7 +242,10 @@ void ExceptionHandler(ExceptionType which)
 		{
 			cerr<<"Load available page frame #"<<avaiPageFrame<<" into main memory!"<<endl;
 		}
-		kernel->currentThread->loadPageFrame(vpn, avaiPageFrame, kernel->currentThread->space->getCurrentNoffHeader().code.inFileAddr+vpn*PageSize, kernel->currentThread->space->getCurrentOpenFile());
+		// a thread resumed with "-lr" first takes its pages from the
+		// suspend image
+		if(!kernel->currentThread->PageInFromImage(vpn, avaiPageFrame))
+			kernel->currentThread->loadPageFrame(vpn, avaiPageFrame, kernel->currentThread->space->getCurrentNoffHeader().code.inFileAddr+vpn*PageSize, kernel->currentThread->space->getCurrentOpenFile());
 		return;
 	}
 	else if(which == TLBMissException)
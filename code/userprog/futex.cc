@@ -0,0 +1,134 @@
+// futex.cc
+//	Routines to put user threads to sleep on a word of their memory,
+//	and to wake them up.  See futex.h.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "futex.h"
+#include "main.h"
+#include "addrspace.h"
+
+FutexTable::FutexTable()
+{
+    for (int i = 0; i < FutexBuckets; i++)
+        buckets[i] = new IntrusiveList<FutexWaiter>(&FutexWaiter::link);
+}
+
+FutexTable::~FutexTable()
+{
+    for (int i = 0; i < FutexBuckets; i++)
+        delete buckets[i];
+}
+
+//----------------------------------------------------------------------
+// FutexTable::Bucket
+// 	Return the list of the waiters whose key hashes like
+//	(space, vaddr).
+//----------------------------------------------------------------------
+
+IntrusiveList<FutexWaiter> *FutexTable::Bucket(AddrSpace *space, int vaddr)
+{
+    unsigned int h = (unsigned int)space->getSpaceID() * 0x9e3779b1u
+                     ^ ((unsigned int)vaddr >> 2);
+
+    return buckets[(h ^ (h >> 16)) & (FutexBuckets - 1)];
+}
+
+//----------------------------------------------------------------------
+// ReadUserWord
+// 	Read the word at "vaddr" of the current address space.  If the
+//	page is not in memory, the read fails after paging it in, so
+//	try again.  Paging in from a system call must not leave the
+//	machine thinking it is back in user mode.
+//----------------------------------------------------------------------
+
+static bool
+ReadUserWord(int vaddr, int *value)
+{
+    MachineStatus status = kernel->interrupt->getStatus();
+    bool ok = FALSE;
+
+    for (int tries = 0; tries < 3 && !ok; tries++)
+        ok = kernel->machine->ReadMem(vaddr, 4, value);
+    kernel->interrupt->setStatus(status);
+    return ok;
+}
+
+//----------------------------------------------------------------------
+// FutexTable::Wait
+// 	Put the current thread to sleep on the word at "vaddr", unless
+//	it no longer holds "expected".  Interrupts are off from the
+//	check until the thread is asleep, so a FutexWake issued after
+//	the word changed cannot be missed.  (If the check has to page
+//	the word in, it reads the word after the page-in, so it is just
+//	as current.)
+//
+//	Returns 0 once woken up, 1 if the word had changed already, -1
+//	if "vaddr" is not a word of the address space.
+//----------------------------------------------------------------------
+
+int FutexTable::Wait(int vaddr, int expected)
+{
+    Thread *currentThread = kernel->currentThread;
+    AddrSpace *space = currentThread->space;
+    int value;
+
+    if ((vaddr & 0x3) || vaddr < 0 || vaddr >= space->getNumPages() * PageSize)
+        return -1;
+
+    IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+    if (!ReadUserWord(vaddr, &value))
+    {
+        (void)kernel->interrupt->SetLevel(oldLevel);
+        return -1;
+    }
+    if (value != expected)
+    {
+        (void)kernel->interrupt->SetLevel(oldLevel);
+        return 1;
+    }
+
+    FutexWaiter waiter(currentThread, space, vaddr);
+    Bucket(space, vaddr)->Append(&waiter);
+    kernel->stats->numFutexWaits++;
+    currentThread->Sleep(FALSE);
+    (void)kernel->interrupt->SetLevel(oldLevel);
+    return 0;
+}
+
+//----------------------------------------------------------------------
+// FutexTable::Wake
+// 	Wake up at most "count" of the threads asleep on the word at
+//	"vaddr" of the current address space, first come first served.
+//----------------------------------------------------------------------
+
+int FutexTable::Wake(int vaddr, int count)
+{
+    AddrSpace *space = kernel->currentThread->space;
+    IntrusiveList<FutexWaiter> *bucket = Bucket(space, vaddr);
+    int woken = 0;
+
+    if (bucket->IsEmpty())
+        return 0;
+
+    IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+    FutexWaiter *waiter = bucket->Front();
+    while (waiter != NULL && woken < count)
+    {
+        FutexWaiter *next = bucket->Next(waiter);
+
+        if (waiter->space == space && waiter->vaddr == vaddr)
+        {
+            bucket->Remove(waiter);
+            kernel->scheduler->ReadyToRun(waiter->thread);
+            woken++;
+        }
+        waiter = next;
+    }
+    kernel->stats->numFutexWakes += woken;
+    (void)kernel->interrupt->SetLevel(oldLevel);
+    return woken;
+}
@@ -0,0 +1,65 @@
+// futex.h
+//	Data structures for "fast user-space mutexes".
+//
+//	A user-level lock keeps its state in a word of user memory and
+//	changes it with LL/SC, so taking and releasing a free lock never
+//	enters the kernel.  Only a thread that finds the lock busy calls
+//	FutexWait, to sleep until the word changes, and only an unlock that
+//	sees there may be sleepers calls FutexWake.
+//
+//	The kernel knows nothing about what the word means: FutexWait just
+//	sleeps if the word still holds the value the caller expects, and
+//	FutexWake wakes up threads asleep on a word.  The sleepers are
+//	kept in a hash table keyed by (address space, virtual address),
+//	in waiter records on their own kernel stacks, so neither call
+//	allocates.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef FUTEX_H
+#define FUTEX_H
+
+#include "copyright.h"
+#include "ilist.h"
+
+class Thread;
+class AddrSpace;
+
+#define FutexBuckets 64		// hash table size, a power of 2
+
+// One thread asleep in FutexWait.
+
+class FutexWaiter {
+  public:
+    FutexWaiter(Thread *t, AddrSpace *s, int addr) : link(this) {
+	thread = t; space = s; vaddr = addr; }
+
+    Thread *thread;
+    AddrSpace *space;		// the word the thread waits on
+    int vaddr;
+    ListLink<FutexWaiter> link;	// on its hash bucket
+};
+
+class FutexTable {
+  public:
+    FutexTable();
+    ~FutexTable();
+
+    int Wait(int vaddr, int expected);
+				// sleep if the word at "vaddr" of the
+				// current address space is "expected";
+				// 0 if we slept, 1 if not, -1 for a
+				// bad address
+    int Wake(int vaddr, int count);
+				// wake up at most "count" threads asleep
+				// on the word; returns how many
+
+  private:
+    IntrusiveList<FutexWaiter> *buckets[FutexBuckets];
+
+    IntrusiveList<FutexWaiter> *Bucket(AddrSpace *space, int vaddr);
+};
+
+#endif // FUTEX_H
@@ -12,6 +12,7 @@
 #define __USERPROG_KSYSCALL_H__ 
 
 #include "kernel.h"
+#include "futex.h"
 
 
 
@@ -28,6 +29,64 @@ int SysAdd(int op1, int op2)
 }
 
 
+/* First thing a thread made by SysThreadFork runs, in the kernel */
+static void UserThreadRoot(int func)
+{
+  Thread *t = kernel->currentThread;
+
+  t->space->ExecuteThread(func, t->userStackSlot);
+}
+
+
+/* Fork a thread running "func" in the caller's address space;
+ * returns its ThreadId, or -1 if the space has no free stack */
+int SysThreadFork(int func)
+{
+  AddrSpace *space = kernel->currentThread->space;
+  int slot = space->AllocUserStack();
+
+  if (slot == -1)
+    return -1;
+
+  Thread *t = new Thread("user thread");
+  t->space = space;
+  t->userStackSlot = slot;
+  space->AddThread(t->getTID());
+  t->Fork((VoidFunctionPtr)UserThreadRoot, (void *)func);
+  return t->getTID();
+}
+
+
+void SysThreadYield()
+{
+  kernel->currentThread->Yield();
+}
+
+
+int SysThreadJoin(int id)
+{
+  return kernel->currentThread->space->Join(id);
+}
+
+
+unsigned int SysClock()
+{
+  return kernel->stats->totalTicks;
+}
+
+
+int SysFutexWait(int addr, int expected)
+{
+  return kernel->futexTable->Wait(addr, expected);
+}
+
+
+int SysFutexWake(int addr, int count)
+{
+  return kernel->futexTable->Wake(addr, count);
+}
+
+
 
 
 
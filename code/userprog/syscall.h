@@ -39,6 +39,8 @@
 #define SC_getThreadID  18
 #define SC_Ipc          19
 #define SC_Clock        20
+#define SC_FutexWait    21
+#define SC_FutexWake    22
 
 #define SC_Add		42
 
@@ -169,6 +171,8 @@ int Close(OpenFileId id);
 /* Fork a thread to run a procedure ("func") in the *same* address space 
  * as the current thread.
  * Return a positive ThreadId on success, negative error code on failure
+ * (at most UserThreadNum threads can share an address space).
+ * "func" runs on a stack of its own and must end by calling ThreadExit.
  */
 ThreadId ThreadFork(void (*func)());
 
@@ -211,6 +215,22 @@ void Ipc(int sendDescriptor, SpaceId r_space, ThreadId r_thread,
  */
 unsigned int Clock();
 
+/* Fast user-level locks.  A lock is a word of user memory, taken and
+ * released with atomic instructions; only a thread that has to wait
+ * for it, or wake up a waiter, needs the kernel.
+ */
+
+/* Sleep until woken up by FutexWake on "addr", unless *addr is no
+ * longer "expected".  Return 0 after sleeping, 1 if *addr had changed,
+ * negative error code if "addr" is not a word of the address space.
+ */
+int FutexWait(int *addr, int expected);
+
+/* Wake up at most "count" threads asleep in FutexWait on "addr".
+ * Return the number woken up.
+ */
+int FutexWake(int *addr, int count);
+
 #endif /* IN_ASM */
 
 #endif /* SYSCALL_H */